@@ -0,0 +1,67 @@
+		.assume adl=1
+		.org $40000
+		jp start
+		.align $40
+
+		.db "MOS"
+		.db 0 ; version
+		.db 1 ; ADL enabled (24-bit addressing)
+
+mos_fopen:		.equ 0x0a
+mos_fclose:		.equ 0x0b
+mos_aread_submit:	.equ 0x66
+mos_aread_poll:		.equ 0x67
+mos_aread_wait:		.equ 0x68
+
+start:
+		push iy
+
+		ld a,mos_fopen
+		ld hl,filename
+		ld c,1			; FA_READ
+		rst.lil 8
+		and a
+		jr z,@done		; could not open file
+		ld (fh),a
+
+		; Queue a read of the whole buffer from the start of the file
+		ld c,a
+		ld hl,buffer
+		ld de,buffer_len
+		ld a,mos_aread_submit
+		rst.lil 8
+		and a
+		jr z,@close		; queue full
+		ld (ticket),a
+
+		; A game would do a frame of work between polls. Each
+		; poll reads at most one slice of the file
+	@loop:
+		ld a,'.'
+		rst.lil 0x10
+		ld a,(ticket)
+		ld c,a
+		ld a,mos_aread_poll
+		rst.lil 8
+		cp 0xff
+		jr z,@loop		; still in progress
+
+		; A = FRESULT, DEU = bytes read
+
+	@close:
+		ld a,mos_fclose
+		ld hl,fh
+		ld c,(hl)
+		rst.lil 8
+
+	@done:
+		ld hl,0
+		pop iy
+		ret
+
+fh:		.db 0
+ticket:		.db 0
+filename:	.db "/mos/readme.txt", 0
+
+buffer_len:	.equ 8192
+buffer:		.ds buffer_len
@@ -0,0 +1,80 @@
+		.assume adl=1
+		.org $40000
+		jp start
+		.align $40
+
+		.db "MOS"
+		.db 0 ; version
+		.db 1 ; ADL enabled (24-bit addressing)
+
+mos_fopen:	.equ 0x0a
+mos_fclose:	.equ 0x0b
+mos_freadv:	.equ 0x65
+
+start:
+		push iy
+
+		ld a,mos_fopen
+		ld hl,filename
+		ld c,1			; FA_READ
+		rst.lil 8
+		and a
+		jr z,@done		; could not open file
+		ld (fh),a
+
+		; Read both records in one call. MOS serves them in
+		; order of offset, so the second one is read first
+		ld a,(fh)
+		ld c,a
+		ld hl,requests
+		ld de,2			; number of requests
+		ld a,mos_freadv
+		rst.lil 8
+
+		ld a,mos_fclose
+		ld hl,fh
+		ld c,(hl)
+		rst.lil 8
+
+		ld hl,rec1
+		ld bc,0
+		xor a
+		rst.lil 0x18
+		ld hl,crlf
+		ld bc,0
+		xor a
+		rst.lil 0x18
+		ld hl,rec2
+		ld bc,0
+		xor a
+		rst.lil 0x18
+		ld hl,crlf
+		ld bc,0
+		xor a
+		rst.lil 0x18
+
+	@done:
+		ld hl,0
+		pop iy
+		ret
+
+fh:		.db 0
+filename:	.db "/mos/readme.txt", 0
+
+; 13 bytes per request: offset (4), length (3), buffer (3), count (3)
+requests:
+		.dl 100			; offset
+		.db 0
+		.dl 16			; length
+		.dl rec1		; buffer
+		.dl 0			; count (set by MOS)
+
+		.dl 0			; offset
+		.db 0
+		.dl 16			; length
+		.dl rec2		; buffer
+		.dl 0			; count (set by MOS)
+
+rec1:		.ds 17, 0
+rec2:		.ds 17, 0
+crlf:		.db "\r\n", 0
@@ -0,0 +1,114 @@
+		.assume adl=1
+		.org $40000
+		jp start
+		.align $40
+
+		.db "MOS"
+		.db 0 ; version
+		.db 1 ; ADL enabled (24-bit addressing)
+
+mos_sysvars:	.equ 0x08
+mos_kbufstats:	.equ 0x6f
+mos_kbufsize:	.equ 0x70
+mos_pollkeyboardevent_ex: .equ 0x71
+
+sysvar_time:	.equ 0x00
+
+; Print how long each key press waited in the keyboard buffer before it was
+; read, in centiseconds. Escape quits, and prints how many events were lost
+start:
+		push iy
+		push ix
+
+		ld c,64			; Make room for 63 events
+		ld a,mos_kbufsize
+		rst.lil 8
+
+		ld a,mos_sysvars
+		rst.lil 8		; IXU = sysvars
+
+	@loop:
+		ld a,mos_pollkeyboardevent_ex
+		ld de,eventbuf
+		rst.lil 8
+		and a
+		jr z,@loop		; no event yet...
+
+		ld a,(e_isdown)
+		and a
+		jr z,@loop		; only key presses
+
+		ld a,(e_ascii)
+		cp 27
+		jr z,@done
+
+		ld hl,(ix+sysvar_time)	; How long since it arrived?
+		ld de,(e_time)
+		or a
+		sbc hl,de
+		call print_dec
+		ld hl,msg_cs
+		ld bc,0
+		xor a
+		rst.lil 0x18
+		jr @loop
+
+	@done:
+		ld a,mos_kbufstats
+		rst.lil 8
+		ld hl,(hl)		; Events dropped
+		call print_dec
+		ld hl,msg_dropped
+		ld bc,0
+		xor a
+		rst.lil 0x18
+
+		ld c,0			; Back to the built in buffer
+		ld a,mos_kbufsize
+		rst.lil 8
+
+		ld hl,0
+		pop ix
+		pop iy
+		ret
+
+; Print HL in decimal
+print_dec:
+		ld b,0			; Digits pushed
+	@div:
+		push bc
+		xor a			; HL = HL / 10, A = remainder
+		ld b,24
+	@bit:
+		add hl,hl
+		rla
+		cp 10
+		jr c,@next
+		sub 10
+		inc l
+	@next:
+		djnz @bit
+		pop bc
+		add a,'0'
+		push af
+		inc b
+		ld de,0
+		or a
+		sbc hl,de
+		jr nz,@div
+	@out:
+		pop af
+		rst.lil 0x10
+		djnz @out
+		ret
+
+eventbuf:
+e_ascii:	.db 0
+e_kmod:		.db 0
+e_vkey:		.db 0
+e_isdown:	.db 0
+e_time:		.ds 4
+msg_cs:
+		.db " cs\r\n", 0
+msg_dropped:
+		.db " events dropped\r\n", 0
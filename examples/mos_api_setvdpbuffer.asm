@@ -0,0 +1,74 @@
+		.assume adl=1
+		.org $40000
+		jp start
+		.align $40
+
+		.db "MOS"
+		.db 0 ; version
+		.db 1 ; ADL enabled (24-bit addressing)
+
+mos_sysvars:		.equ 0x08
+mos_setvdpbuffer:	.equ 0x69
+
+sysvar_time:		.equ 0x00
+sysvar_vpd_pflags:	.equ 0x04
+sysvar_vdpBulkCmd:	.equ 0x5b
+sysvar_vdpBulkLen:	.equ 0x5c
+vdp_pflag_bulk:		.equ 0x80
+
+start:
+		push iy
+		push ix
+
+		; Packets from the VDP longer than 16 bytes now go to buffer
+		ld hl,buffer
+		ld c,buffer_len
+		ld a,mos_setvdpbuffer
+		rst.lil 8
+
+		ld a,mos_sysvars
+		rst.lil 8		; IXU = sysvars
+
+		; Send the VDP request that replies with a long packet here
+
+		; Wait up to a second for it to arrive
+		ld hl,(ix+sysvar_time)
+		ld de,100
+		add hl,de
+		ex de,hl
+	@wait:
+		ld a,(ix+sysvar_vpd_pflags)
+		and vdp_pflag_bulk
+		jr nz,@got
+		ld hl,(ix+sysvar_time)
+		or a
+		sbc hl,de
+		jr c,@wait
+		ld hl,msg_timeout
+		jr @print
+
+	@got:
+		; The packet is in buffer, and (ix+sysvar_vdpBulkLen) bytes long.
+		; Its command byte is in (ix+sysvar_vdpBulkCmd)
+		ld hl,msg_got
+
+	@print:
+		ld bc,0
+		xor a
+		rst.lil 0x18
+
+		; Stop receiving long packets. This also clears the flag
+		ld c,0
+		ld a,mos_setvdpbuffer
+		rst.lil 8
+
+		ld hl,0
+		pop ix
+		pop iy
+		ret
+
+msg_got:	.db "Long packet received\r\n", 0
+msg_timeout:	.db "No long packet received\r\n", 0
+
+buffer_len:	.equ 255
+buffer:		.ds buffer_len
@@ -0,0 +1,98 @@
+		.assume adl=1
+		.org $40000
+		jp start
+		.align $40
+
+		.db "MOS"
+		.db 0 ; version
+		.db 1 ; ADL enabled (24-bit addressing)
+
+mos_sysvars:	.equ 0x08
+mos_uopen:	.equ 0x15
+mos_uclose:	.equ 0x16
+mos_ugetc_nb:	.equ 0x6a
+mos_uputc_nb:	.equ 0x6b
+mos_ustats:	.equ 0x6c
+
+sysvar_keyascii:	.equ 0x05
+sysvar_vkeydown:	.equ 0x18
+sysvar_vkeycount:	.equ 0x19
+
+; A simple terminal that never waits on UART1: what is received is
+; printed, and keys pressed are sent. Escape quits
+start:
+		push iy
+		push ix
+
+		ld ix,uart1
+		ld a,mos_uopen
+		rst.lil 8
+		or a
+		jr nz,@done
+
+		ld a,mos_sysvars
+		rst.lil 8		; IXU = sysvars
+		ld a,(ix+sysvar_vkeycount)
+		ld (keycount),a
+
+	@loop:
+		ld a,mos_ugetc_nb	; Anything received?
+		rst.lil 8
+		jr nc,@key
+		rst.lil 0x10		; Yes, so print it
+		jr @loop
+
+	@key:
+		ld a,(keycount)		; Any key event?
+		cp (ix+sysvar_vkeycount)
+		jr z,@loop
+		ld a,(ix+sysvar_vkeycount)
+		ld (keycount),a
+		ld a,(ix+sysvar_vkeydown)	; Only send when pressed
+		or a
+		jr z,@loop
+		ld a,(ix+sysvar_keyascii)
+		cp 27
+		jr z,@close
+		ld c,a
+	@send:
+		ld a,mos_uputc_nb	; Queue it; if the transmit ring is
+		rst.lil 8		; full, keep receiving while it drains
+		jr c,@loop
+		ld a,mos_ugetc_nb
+		rst.lil 8
+		jr nc,@send
+		rst.lil 0x10
+		jr @send
+
+	@close:
+		ld a,mos_ustats		; HLU: Pointer to the statistics
+		rst.lil 8
+		ld de,(hl)		; Characters lost to FIFO overruns
+		inc hl
+		inc hl
+		inc hl
+		ld hl,(hl)		; Characters lost to a full receive ring
+		add hl,de
+		ld (lost),hl
+
+		ld a,mos_uclose
+		rst.lil 8
+		xor a
+
+	@done:
+		ld hl,0
+		ld l,a
+		pop ix
+		pop iy
+		ret
+
+keycount:	.db 0
+lost:		.dl 0
+
+uart1:		.dl 115200	; Baud rate
+		.db 8		; Data bits
+		.db 1		; Stop bits
+		.db 0		; Parity
+		.db 1		; Hardware flow control (RTS/CTS)
+		.db 0		; Interrupts (ignored)
@@ -0,0 +1,63 @@
+		.assume adl=1
+		.org $40000
+		jp start
+		.align $40
+
+		.db "MOS"
+		.db 0 ; version
+		.db 1 ; ADL enabled (24-bit addressing)
+
+mos_uopen:	.equ 0x15
+mos_uclose:	.equ 0x16
+mos_uread:	.equ 0x6d
+mos_uwrite:	.equ 0x6e
+
+; Echo blocks back down UART1 until nothing has arrived for 5 seconds
+start:
+		push iy
+		push ix
+
+		ld ix,uart1
+		ld a,mos_uopen
+		rst.lil 8
+		or a
+		jr nz,@done
+
+	@loop:
+		ld hl,buffer		; Wait for up to a buffer's worth
+		ld de,buffer_len
+		ld bc,5000		; for up to 5 seconds
+		ld a,mos_uread
+		rst.lil 8		; DEU: Bytes read
+		ld hl,0
+		or a
+		adc hl,de
+		jr z,@close		; Timed out with nothing read
+
+		ld hl,buffer		; Send them back, waiting as long
+		ld bc,1000		; as a second for room to queue them
+		ld a,mos_uwrite
+		rst.lil 8
+		jr @loop
+
+	@close:
+		ld a,mos_uclose
+		rst.lil 8
+		xor a
+
+	@done:
+		ld hl,0
+		ld l,a
+		pop ix
+		pop iy
+		ret
+
+uart1:		.dl 115200	; Baud rate
+		.db 8		; Data bits
+		.db 1		; Stop bits
+		.db 0		; Parity
+		.db 1		; Hardware flow control (RTS/CTS)
+		.db 0		; Interrupts (ignored)
+
+buffer_len:	.equ 1024
+buffer:		.ds buffer_len
@@ -0,0 +1,224 @@
+/*
+ * Asynchronous file reads
+ *
+ * A read is queued with aread_submit and done a slice at a time, each
+ * time the application polls or waits on it (or any other queued read),
+ * and whenever MOS would otherwise sleep waiting for a key or an event.
+ * Everything runs in the context of a MOS API call, never from an
+ * interrupt, so FatFS (built with FF_FS_REENTRANT=0) is never entered
+ * twice. Reads are served oldest first.
+ *
+ * Each read on a handle starts where the one queued before it ends, and
+ * the file pointer is left after the last of them. Until then, calls that
+ * use or move the file pointer are refused (see aread_busy).
+ */
+#include "async_read.h"
+#include "config.h"
+#include "mos.h"
+
+enum aread_state {
+	AREAD_FREE,
+	AREAD_QUEUED,
+	AREAD_DONE,
+};
+
+typedef struct {
+	uint8_t state;
+	uint8_t fh;
+	uint8_t result;	   // FRESULT, once done
+	uint24_t serial;   // Submission order
+	uint32_t offset;   // Offset of the next byte to read
+	uint8_t *buffer;   // Where to put it
+	uint24_t remaining;
+	uint24_t count;	   // Bytes read so far
+} t_aread;
+
+static t_aread aread_queue[MOS_areadQueueLen];
+static uint24_t aread_serial;
+
+uint8_t aread_queued;	// Number of reads queued, checked by the FGETC/FPUTC fast paths
+
+// Finish a queued read
+//
+static void aread_finish(t_aread *r, uint8_t result)
+{
+	r->result = result;
+	r->state = AREAD_DONE;
+	aread_queued--;
+}
+
+// Queue a read from the current file pointer, or from the end of the read
+// last queued on the same handle
+// Parameters:
+// - fh: File handle
+// - buffer: Address to read the data into
+// - length: Number of bytes to read
+// Returns:
+// - Ticket (1 onwards), or 0 if the handle is not open or the queue is full
+//
+uint8_t aread_submit(uint8_t fh, uint24_t buffer, uint24_t length)
+{
+	FIL *fo = (FIL *)mos_GETFIL(fh);
+	t_aread *r, *last = NULL;
+	int i;
+
+	if (fo == 0) {
+		return 0;
+	}
+	for (i = 0; i < MOS_areadQueueLen; i++) {
+		r = &aread_queue[i];
+		if (r->state == AREAD_QUEUED && r->fh == fh && (last == NULL || (int24_t)(r->serial - last->serial) > 0)) {
+			last = r;
+		}
+	}
+	for (i = 0; i < MOS_areadQueueLen; i++) {
+		r = &aread_queue[i];
+		if (r->state == AREAD_FREE) {
+			r->state = length ? AREAD_QUEUED : AREAD_DONE;
+			r->fh = fh;
+			r->result = FR_OK;
+			r->serial = aread_serial++;
+			r->offset = last ? last->offset + last->remaining : f_tell(fo);
+			r->buffer = (uint8_t *)buffer;
+			r->remaining = length;
+			r->count = 0;
+			if (length) {
+				aread_queued++;
+			}
+			return i + 1;
+		}
+	}
+	return 0;
+}
+
+// Do the next slice of the oldest queued read, if there is one
+// Slices end on a sector boundary, so after the first one FatFS reads
+// whole sectors straight into the destination
+// Returns:
+// - true if a slice was done, false if there was nothing queued
+//
+bool aread_service(void)
+{
+	t_aread *r = NULL;
+	FIL *fo;
+	FRESULT fr;
+	UINT len, br = 0;
+	int i;
+
+	for (i = 0; i < MOS_areadQueueLen; i++) {
+		t_aread *q = &aread_queue[i];
+		if (q->state == AREAD_QUEUED && (r == NULL || (int24_t)(q->serial - r->serial) < 0)) {
+			r = q;
+		}
+	}
+	if (r == NULL) {
+		return false;
+	}
+
+	fo = (FIL *)mos_GETFIL(r->fh);
+	if (fo == 0) {
+		aread_finish(r, FR_INVALID_OBJECT);
+		return true;
+	}
+	len = MOS_areadSliceSize - (UINT)(r->offset % FF_MAX_SS);
+	len = MIN(len, r->remaining);
+
+	fr = f_lseek(fo, r->offset);
+	if (fr == FR_OK) {
+		fr = f_read(fo, r->buffer, len, &br);
+	}
+	r->offset += br;
+	r->buffer += br;
+	r->remaining -= br;
+	r->count += br;
+	if (fr != FR_OK || br < len || r->remaining == 0) {
+		aread_finish(r, fr);
+	}
+	return true;
+}
+
+// Do a slice of queued reads, then check on a ticket
+// A ticket is freed once it has been reported as done
+// Parameters:
+// - ticket: Ticket returned by aread_submit
+// - count: Set to the number of bytes read so far
+// Returns:
+// - AREAD_PENDING, or the FRESULT of the finished read
+//
+uint8_t aread_poll(uint8_t ticket, uint24_t *count)
+{
+	t_aread *r;
+
+	*count = 0;
+	if (ticket == 0 || ticket > MOS_areadQueueLen) {
+		return FR_INVALID_PARAMETER;
+	}
+	r = &aread_queue[ticket - 1];
+	if (r->state == AREAD_FREE) {
+		return FR_INVALID_PARAMETER;
+	}
+	if (r->state == AREAD_QUEUED) {
+		aread_service();
+	}
+	*count = r->count;
+	if (r->state == AREAD_QUEUED) {
+		return AREAD_PENDING;
+	}
+	r->state = AREAD_FREE;
+	return r->result;
+}
+
+// Wait for a read to finish, doing queued reads until it does
+// Parameters:
+// - ticket: Ticket returned by aread_submit
+// - count: Set to the number of bytes read
+// Returns:
+// - FRESULT of the read
+//
+uint8_t aread_wait(uint8_t ticket, uint24_t *count)
+{
+	uint8_t status;
+
+	do {
+		status = aread_poll(ticket, count);
+	} while (status == AREAD_PENDING);
+	return status;
+}
+
+// Fail any queued reads on a file handle that is being closed
+// Parameters:
+// - fh: File handle, or 0 for all
+//
+void aread_cancel(uint8_t fh)
+{
+	int i;
+
+	for (i = 0; i < MOS_areadQueueLen; i++) {
+		t_aread *r = &aread_queue[i];
+		if (r->state == AREAD_QUEUED && (fh == 0 || r->fh == fh)) {
+			aread_finish(r, FR_INVALID_OBJECT);
+		}
+	}
+}
+
+// Check whether a file handle has reads queued on it
+// Parameters:
+// - fh: File handle
+// Returns:
+// - true if so, in which case its file pointer must be left alone
+//
+bool aread_busy(uint8_t fh)
+{
+	int i;
+
+	if (aread_queued == 0) {
+		return false;
+	}
+	for (i = 0; i < MOS_areadQueueLen; i++) {
+		t_aread *r = &aread_queue[i];
+		if (r->state == AREAD_QUEUED && r->fh == fh) {
+			return true;
+		}
+	}
+	return false;
+}
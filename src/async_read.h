@@ -0,0 +1,19 @@
+#ifndef ASYNC_READ_H
+#define ASYNC_READ_H
+
+#include "defines.h"
+
+// Status returned by aread_poll and aread_wait while a read is in progress.
+// Once it finishes they return its FRESULT instead
+#define AREAD_PENDING 0xFF
+
+extern uint8_t aread_submit(uint8_t fh, uint24_t buffer, uint24_t length);
+extern uint8_t aread_poll(uint8_t ticket, uint24_t *count);
+extern uint8_t aread_wait(uint8_t ticket, uint24_t *count);
+extern bool aread_service(void);
+extern void aread_cancel(uint8_t fh);
+extern bool aread_busy(uint8_t fh);
+
+extern uint8_t aread_queued;
+
+#endif /* ASYNC_READ_H */
@@ -14,9 +14,19 @@
 #define enable_config 1			// 0 = disable boot config loading, 1 = enable
 
 #define MOS_prompt '*'			// MOS prompt character
-#define MOS_maxOpenFiles 8		// Maximum number of files that mos_FOPEN can open at the same time
+#define MOS_maxOpenFiles 32		// Maximum number of files that mos_FOPEN can open at the same time
+#define MOS_openFilesGrowBy 8		// Handles added each time the mos_FOPEN handle table fills up
+#define MOS_filesPerSlab 4		// FIL objects allocated from the heap at a time
+#define MOS_areadQueueLen 4		// Asynchronous reads that can be queued at once
+#define MOS_areadSliceSize 1024		// Most bytes an asynchronous read does per poll (a multiple of 512)
 #define MOS_defaultLoadAddress 0x040000 // Default load address for LOAD and RUN commands
 #define MOS_starLoadAddress 0xB0000	// Address for loading on-SD star commands
+#define MOS_execChunkSize 2048		// Largest part of a batch file that mos_EXEC reads at once
+#define MOS_vdpTimeout 1000		// How long to wait for a reply from the VDP, in milliseconds
+#define MOS_uart1RxBufSize 256		// UART1 receive ring size (a power of 2, at least 128)
+#define MOS_uart1TxBufSize 128		// UART1 transmit ring size (a power of 2)
+#define MOS_sideloadBuffer 0x040000	// RAM used by SIDELOAD <file>: a capture ring, then a double buffer
+#define MOS_sideloadBufferSize 0x4000	// Size of the ring, and each half of the buffer (a power of 2)
 #define MOS_externLastRAMaddress 0xBFFFF
 
 #define FEAT_FRAMEBUFFER
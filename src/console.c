@@ -32,23 +32,59 @@ void vdpGetModeInformation()
 //
 uint8_t vdpReadPalette(uint8_t entry)
 {
+	uint8_t known = vdp_colours_known; // The request itself does not change the colours
 	vpd_protocol_flags &= 0xFB; // Clear the semaphore flag
 	putch(23);
 	putch(0);
 	putch(VDP_palette);
 	putch(entry);
 	wait_VDP(0x04);
+	vdp_colours_known = known;
 	return scrpixelIndex;
 }
 
+// The VDP's text colours, shadowed so they need not be read back every time
+// UART0_serial_PUTCH and UART0_serial_WRITE clear vdp_colours_known when they send
+// any of VDU 17 to 23, as does vdp_protocol_MODE when the screen mode changes
+//
+uint8_t vdp_colours_known;
+static uint8_t vdp_fg, vdp_bg;
+
 uint8_t vdp_get_fg_color_index()
 {
-	return vdpReadPalette(128);
+	if (!(vdp_colours_known & VDP_COLOUR_FG)) {
+		vdp_fg = vdpReadPalette(128);
+		vdp_colours_known |= VDP_COLOUR_FG;
+	}
+	return vdp_fg;
 }
 
 uint8_t vdp_get_bg_color_index()
 {
-	return vdpReadPalette(129);
+	if (!(vdp_colours_known & VDP_COLOUR_BG)) {
+		vdp_bg = vdpReadPalette(129);
+		vdp_colours_known |= VDP_COLOUR_BG;
+	}
+	return vdp_bg;
+}
+
+// Set a text colour with VDU 17, and remember it
+//
+void console_set_color(uint8_t col)
+{
+	uint8_t known = vdp_colours_known;
+	putch(17);
+	putch(col);
+	if (scrcolours == 0) {
+		return;
+	}
+	if (col & 0x80) {
+		vdp_bg = (col & 0x7F) % scrcolours;
+		vdp_colours_known = known | VDP_COLOUR_BG;
+	} else {
+		vdp_fg = col % scrcolours;
+		vdp_colours_known = known | VDP_COLOUR_FG;
+	}
 }
 
 void fbGetCursorPos()
@@ -75,7 +111,7 @@ uint8_t fb_get_fg_color_index()
 uint8_t fb_get_bg_color_index()
 {
 	for (int i = 0; i < 16; i++) {
-		if (fb_vdp_palette[i] == fbterm_fg) {
+		if (fb_vdp_palette[i] == fbterm_bg) {
 			return i;
 		}
 	}
@@ -104,7 +140,7 @@ struct console_driver_t *active_console = &vdp_console;
 void console_enable_fb()
 {
 	active_console = &fb_console;
-	/* Call mos_api_setresetvector to set rst10 vector */
+	/* Call mos_api_setresetvector to set rst10 and rst18 vectors */
 	asm volatile(
 	    "push de\n"
 	    "push hl\n"
@@ -112,6 +148,10 @@ void console_enable_fb()
 	    "ld e,0x10 \n"
 	    "ld hl,_fbconsole_rst10_handler \n"
 	    "rst.lil 8\n"
+	    "ld a,0x61 \n"
+	    "ld e,0x18 \n"
+	    "ld hl,_fbconsole_rst18_handler \n"
+	    "rst.lil 8\n"
 	    "pop hl\n"
 	    "pop de\n");
 }
@@ -119,7 +159,8 @@ void console_enable_fb()
 void console_enable_vdp()
 {
 	active_console = &vdp_console;
-	/* Call mos_api_setresetvector to set rst10 vector */
+	vdp_colours_known = 0; // Anything sent to the framebuffer console was not seen by the VDP
+	/* Call mos_api_setresetvector to set rst10 and rst18 vectors */
 	asm volatile(
 	    "push de\n"
 	    "push hl\n"
@@ -127,6 +168,10 @@ void console_enable_vdp()
 	    "ld e,0x10 \n"
 	    "ld hl,rst_10_handler \n"
 	    "rst.lil 8\n"
+	    "ld a,0x61 \n"
+	    "ld e,0x18 \n"
+	    "ld hl,rst_18_handler \n"
+	    "rst.lil 8\n"
 	    "pop hl\n"
 	    "pop de\n");
 }
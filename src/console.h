@@ -10,8 +10,14 @@ struct console_driver_t {
 	uint8_t (*get_bg_color_index)();
 };
 
+#define VDP_COLOUR_FG	0x01 // Bits in vdp_colours_known
+#define VDP_COLOUR_BG	0x02
+
 extern void console_enable_fb();
 extern void console_enable_vdp();
+extern void console_set_color(uint8_t col);
+
+extern uint8_t vdp_colours_known;
 
 extern struct console_driver_t vdp_console;
 extern struct console_driver_t fb_console;
@@ -13,6 +13,7 @@
 		.global _fb_driverversion
 		.global _fb_base
 		.global _fbconsole_rst10_handler
+		.global _fbconsole_rst18_handler
 		.global _fb_vdp_palette
 
 FONT_WIDTH: .equ 4
@@ -36,6 +37,12 @@ vdp_fn_args:	.ds 1
 fbterm_flags:	.ds 1
 _fb_base: 	.ds 3
 cursor_mutex:	.ds 1	; 1 when free, 0 when held
+fb_scanline_tab: .ds 3	; pointer per scanline, that the driver displays from
+fb_tab_line_bytes: .ds 3 ; bytes of fb_scanline_tab per pixel row (scan_multiplier entries)
+fb_tab_row_bytes: .ds 3	; bytes of fb_scanline_tab per text row
+fb_width:	.ds 3	; screen.width, so drawing need not ask the driver
+glyph_tab_fg:	.ds 1	; colours glyph_tab was built for
+glyph_tab_bg:	.ds 1
 ; struct font same as fbfont_0, fbfont_1
 fbfont:
 	fbfont_width:	.ds 1
@@ -44,6 +51,12 @@ fbfont:
 
 fbdata_end:
 
+; Pixels for each 4-bit pattern of a font row, in glyph_tab_fg and
+; glyph_tab_bg. Aligned so an entry's address is glyph_tab|(pattern*4).
+; All 0 to start with, which is right for the 0 and 0 it claims
+		.balign 64
+glyph_tab:	.ds 64
+
 FLAG_IS_CURSOR_VIS: .equ 1
 FLAG_DELAYED_SCROLL: .equ 2
 FLAG_LOGO_DISMISSED: .equ 4
@@ -145,6 +158,7 @@ _start_fbterm:
 		ld (iy+1),hl
 		ld hl,(ix+12)	; fb_scanline_offsets
 		ld (iy+4),hl
+		ld (fb_scanline_tab),hl
 		ld hl,pre_image_callback_off
 		ld (iy+7),hl	; pre_image_callback: disabled until init all done
 
@@ -222,6 +236,70 @@ _fbconsole_rst10_handler:
 		ret.lil
 
 
+; Write a block of bytes to the terminal, taking the cursor mutex
+; and hiding the cursor once for the whole block.
+; HLU: buffer address, BC: size of buffer, A: delimiter (only if BC = 0)
+_fbconsole_rst18_handler:
+		ld e,a			; preserve the delimiter
+		ld a,mb
+		or a
+		call nz,SET_AHL24
+
+		; If rst 0x10 has been redirected elsewhere, use the
+		; byte-at-a-time path so the new handler sees every byte
+		push hl
+		push de
+		ld hl,(ram_rst_10_handler+1)
+		ld de,_fbconsole_rst10_handler
+		or a
+		sbc hl,de
+		pop de
+		pop hl
+		ld a,e
+		jp nz,rst_18_handler
+
+		push ix
+		push iy
+
+		push bc
+		push de
+		push hl
+		; Try to take cursor mutex
+		ld hl,cursor_mutex
+	1:	srl (hl)
+		jr nc,1b		; nope. someone else holds it
+
+		call hide_cursor
+		pop hl
+		pop de
+		pop bc
+
+		ld a,b
+		or c
+		jr z,3f
+		ld e,0			; no delimiter
+	2:	; length-counted
+		call term_write
+		ld a,b
+		or c
+		jr nz,2b
+		jr 4f
+	3:	; delimited
+		ld a,(hl)
+		cp e
+		jr z,4f
+		ld bc,-1		; no length
+		call term_write
+		jr 3b
+	4:
+		; Release cursor mutex
+		ld hl,cursor_mutex
+		inc (hl)
+
+		pop iy
+		pop ix
+		ret.lil
+
 term_init:	; size the terminal. needed after mode change
 		push ix
 		push iy
@@ -239,6 +317,22 @@ term_init:	; size the terminal. needed after mode change
 		ld bc,5
 		ldir
 
+		; size of the scanline table per pixel row and per text row
+		ld hl,(iy+12)	; screen.scan_multiplier
+		push hl
+		pop de
+		add hl,hl
+		add hl,de	; 3 bytes per entry
+		ld (fb_tab_line_bytes),hl
+		ld de,0
+		ld a,(fbfont_height)
+		ld e,a
+		call umul24
+		ld (fb_tab_row_bytes),hl
+
+		ld hl,(iy+6)	; screen.width
+		ld (fb_width),hl
+
 		ld hl,(iy+6)	; screen.width
 		ld de,0
 		ld a,(fbfont_width)
@@ -279,6 +373,99 @@ term_putch:	; character in `a`
 		ld hl,(vdp_active_fn)
 		jp (hl)
 
+; Write at least one character from (hl) to the terminal, drawing a run of
+; printable ones in one go when not in the middle of a VDU sequence
+; e: delimiter that ends a run, or 0 for none
+; Returns hl and bc advanced past the characters written
+term_write:
+		ld a,(hl)
+		cp 32
+		jr c,1f
+		cp 127
+		jr nc,1f
+		push de
+		push hl
+		ld hl,(vdp_active_fn)
+		ld de,_interpret_char
+		or a
+		sbc hl,de
+		pop hl
+		pop de
+		jr z,term_write_run
+	1:
+		push bc
+		push de
+		push hl
+		call term_putch
+		pop hl
+		pop de
+		pop bc
+		inc hl
+		dec bc
+		ret
+
+; Draw printable characters from (hl) until the end of the line, one
+; that is not printable or is the delimiter in e, or bc runs out. The
+; cursor pointer moves along a cell at a time, and the cursor position
+; is only written at the end
+term_write_run:
+		push bc
+		push de
+		push hl
+		call do_scroll_if_needed
+		call update_glyph_tab
+		pop hl
+		pop de
+		pop bc
+		ld a,(_fb_curs_x)
+		ld d,a			; d = column
+	1:
+		ld a,(hl)
+		push bc
+		push de
+		push hl
+		call draw_glyph
+		ld hl,(fb_curs_ptr)
+		ld de,0
+		ld a,(fbfont_width)
+		ld e,a
+		add hl,de
+		ld (fb_curs_ptr),hl
+		pop hl
+		pop de
+		pop bc
+		inc hl
+		dec bc
+		inc d
+		ld a,(term_width)
+		cp d
+		jr z,3f			; end of the line
+		ld a,b
+		or c
+		jr z,2f
+		ld a,(hl)
+		cp e
+		jr z,2f
+		cp 32
+		jr c,2f
+		cp 127
+		jr c,1b
+	2:
+		ld a,d
+		ld (_fb_curs_x),a
+		ret
+	3:	; go to the next line, as move_cursor_right does
+		xor a
+		ld (_fb_curs_x),a
+		push bc
+		push de
+		push hl
+		call move_cursor_down
+		pop hl
+		pop de
+		pop bc
+		ret
+
 	.balign 0x10
 _fb_vdp_palette:
 		db 0, 0b1100000, 0b1100, 0b1101100, 0b1, 0b1100001, 0b1101, 0b1101101
@@ -638,9 +825,8 @@ _interpret_char:
 		push hl
 		pop bc
 		pop de
-		call umul24	; hl=screen.width*font.height*line_no
-		ld de,(_fb_base)
-		add hl,de
+		ld a,e
+		call get_hl_ptr_text_row
 		xor a
 		ld (hl),a
 		push hl
@@ -669,35 +855,49 @@ do_scroll_if_needed:
 		call do_scroll
 		ret
 
+; Scroll up a line by rotating the scanline table a text row, rather than
+; moving the framebuffer, then clear the row that comes in at the bottom
 do_scroll:
-		call fb_get_modeinfo
-		; bc = screen.width * (screen.height-font.height)
-		ld de,(iy+6)	; screen.width
-		ld hl,(iy+9)	; screen.height
-		ld bc,0
-		ld a,(fbfont_height)
-		ld c,a
+		ld ix,0
+		add ix,sp
+		ld bc,(fb_tab_row_bytes)
+		lea hl,ix+0
 		or a
 		sbc hl,bc
-		call umul24
-		push hl
-		pop bc
+		ld sp,hl	; room below the stack for the top row's entries
 
-		ld hl,(iy+6)	; screen.width
+		ex de,hl	; save them there
+		ld hl,(fb_scanline_tab)
+		ldir
+
+		push hl		; move the other rows' entries up
+		ld hl,(fb_tab_row_bytes)
 		ld de,0
-		ld a,(fbfont_height)
+		ld a,(term_height)
+		dec a
 		ld e,a
-		call umul24	; hl=screen.width*6
-		ld de,(_fb_base)
-		add hl,de
+		call umul24
+		push hl
+		pop bc
+		pop hl
+		ld de,(fb_scanline_tab)
+		ldir
 
+		ld hl,0		; and put the top row's entries at the bottom
+		add hl,sp
+		ld bc,(fb_tab_row_bytes)
 		ldir
-		
+		ld sp,ix
+
+		call fb_get_modeinfo
 		ld de,0
 		ld a,(term_height)
 		dec a
 		ld e,a
 		call .clear_line
+
+		; the cursor row has moved in the framebuffer
+		call update_curs_ptr
 		ret
 
 ; Input:
@@ -708,49 +908,111 @@ do_scroll:
 ;   the character.
 raw_draw_char:
 		push af
-		; modeinfo to iy
-		call fb_get_modeinfo
-		ld hl,(fb_curs_ptr)
-		push hl
-		pop ix
+		call update_glyph_tab
 		pop af
+draw_glyph:	; the same, when glyph_tab is known to be up to date
 		; seek to character in font
 		ld b,a
 		ld a,(fbfont_height)
 		ld c,a
 		mlt bc
-		ld hl,(fbfont_bitmap)
-		add hl,bc
-		; draw it
+		ld ix,(fbfont_bitmap)
+		add ix,bc
+		; draw it, a row at a time from glyph_tab
 		ld b,a	; fbfont_height
-		ld a,(_fbterm_fg)
-		ld d,a
-		ld a,(_fbterm_bg)
-		ld e,a
-	.lineloop:
-		ld c,(hl)
-		inc hl
-		push hl
-		lea hl,ix+0		; framebuffer write position
-		push bc
+		ld c,255	; so ldi never borrows from b
+		ld de,(fb_curs_ptr)
 		ld a,(fbfont_width)
-		ld b,a
-	1:	rlc c
-		ld a,e
-		jr nc,2f
-		ld a,d
-	2:	ld (hl),a
-		inc hl
-		djnz 1b
-		pop bc
+		cp 4
+		jr nz,.wideloop
+	.lineloop:	; 4 pixels wide: the top 4 bits of each font row
+		push de
+		ld a,(ix+0)
+		inc ix
+		and 0xf0
+		rrca
+		rrca
+		ld hl,glyph_tab
+		or l
+		ld l,a
+		ldi
+		ldi
+		ldi
+		ldi
 		pop hl
+		ld de,(fb_width)
+		add hl,de
+		ex de,hl
+		djnz .lineloop
+		ret
 
+	.wideloop:	; 6 pixels wide: the top 6 bits of each font row
 		push de
-		ld de,(iy+6)
-		add ix,de
-		pop de
-		djnz .lineloop
+		ld a,(ix+0)
+		and 0xf0
+		rrca
+		rrca
+		ld hl,glyph_tab
+		or l
+		ld l,a
+		ldi
+		ldi
+		ldi
+		ldi
+		ld a,(ix+0)
+		inc ix
+		and 0x0f
+		rlca
+		rlca
+		ld hl,glyph_tab
+		or l
+		ld l,a
+		ldi
+		ldi
+		pop hl
+		ld de,(fb_width)
+		add hl,de
+		ex de,hl
+		djnz .wideloop
+		ret
 
+; Rebuild glyph_tab if the colours have changed since it was built
+update_glyph_tab:
+		ld a,(_fbterm_fg)
+		ld hl,glyph_tab_fg
+		cp (hl)
+		jr nz,1f
+		ld a,(_fbterm_bg)
+		inc hl		; glyph_tab_bg
+		cp (hl)
+		ret z
+	1:
+		ld a,(_fbterm_fg)
+		ld (glyph_tab_fg),a
+		ld d,a
+		ld a,(_fbterm_bg)
+		ld (glyph_tab_bg),a
+		ld e,a
+		ld hl,glyph_tab
+		ld c,0		; 4-bit pattern
+	2:
+		ld a,c
+		rlca
+		rlca
+		rlca
+		rlca
+		ld b,4
+	3:
+		rlca
+		ld (hl),e
+		jr nc,4f
+		ld (hl),d
+	4:
+		inc hl
+		djnz 3b
+		inc c
+		bit 4,c
+		jr z,2b
 		ret
 
 fb_cls:
@@ -846,17 +1108,8 @@ get_hl_ptr_cursor_pos:
 		call fb_get_modeinfo	; iy
 	
 		; find character y position
-		ld hl,(iy+6)	; screen.width
-		ld de,0
-		ld a,(fbfont_height)
-		ld e,a
-		call umul24	; hl=screen.width*font.height
-
-		; hl=screen.width*font.height*_fb_curs_y
-		ld de,0
 		ld a,(_fb_curs_y)
-		ld e,a
-		call umul24
+		call get_hl_ptr_text_row
 
 		; seek x character pos in framebuffer
 		ld a,(_fb_curs_x)
@@ -866,13 +1119,21 @@ get_hl_ptr_cursor_pos:
 		mlt bc
 		add hl,bc
 
-		; add base framebuffer address
-		ld de,(_fb_base)
-		add hl,de
-
 		pop ix
 		ret
 
+; hl = framebuffer address of the top of text row `a`. corrupts de
+; Scrolling moves the rows around, so this looks it up in the scanline table
+get_hl_ptr_text_row:
+		ld hl,(fb_tab_row_bytes)
+		ld de,0
+		ld e,a
+		call umul24
+		ld de,(fb_scanline_tab)
+		add hl,de
+		ld hl,(hl)
+		ret
+
 _fb_driverversion:
 		xor a
 		rst.lil 0x20
@@ -918,14 +1179,14 @@ always_draw_trippy_logo:
 		ld a,(iy+0) ; frame count
 		push af
 
-		call fb_get_modeinfo	; iy
-		; splash logo
-		ld de,(_fb_base)
+		; splash logo, at the top of the screen wherever scrolling has
+		; moved that to in the framebuffer
+		ld iy,(fb_scanline_tab)
 		ld hl,logo
 		ld b,LOGO_H
 	1:	push bc
 		ld b,LOGO_W
-		push de
+		ld de,(iy+0)
 
 		; color in c
 		inc (ix-2)
@@ -946,14 +1207,10 @@ always_draw_trippy_logo:
 		dec b
 		jr nz,2b
 
-		pop de
 		pop bc
-		; next line (de += screen.width)
-		push hl
-		ld hl,(iy+6)  ; screen.width
-		add hl,de
-		ex de,hl
-		pop hl
+		; next line of the scanline table
+		ld de,(fb_tab_line_bytes)
+		add iy,de
 		djnz 1b
 
 		pop af
@@ -25,19 +25,28 @@ void paginated_start(bool enabled)
 	paginated_enabled = enabled;
 }
 
+// Output in here goes through kputch, and each public function flushes
+// what it has written before returning
+//
+static void set_color_buffered(uint8_t col)
+{
+	kputch(17);
+	kputch(col);
+}
+
 void set_color(uint8_t col)
 {
-	putch(17);
-	putch(col);
+	kflush();
+	console_set_color(col);
 }
 
 static void clear_line()
 {
-	putch('\r');
+	kputch('\r');
 	for (uint8_t i = scrcols - 1; i > 0; i--) {
-		putch(' ');
+		kputch(' ');
 	}
-	putch('\r');
+	kputch('\r');
 }
 
 uint8_t get_secondary_color()
@@ -61,7 +70,7 @@ static void handle_newline()
 	if (paginated_row >= scrrows - 2) {
 		paginated_page++;
 		paginated_row = 0;
-		set_color(oldFgCol);
+		set_color(oldFgCol);		// Flushes the page before looking at the keyboard
 		if (!paginated_enabled) {
 			if (kbuf_poll_event(&ev) && ev.isdown) {
 				paginated_enabled = true;
@@ -73,8 +82,8 @@ static void handle_newline()
 		}
 		if (paginated_enabled) {
 			// yellow in most modes. visible in all
-			set_color(get_primary_color());
-			kprintf("--Page %d-- (ESC/q/c/any key)", paginated_page);
+			set_color_buffered(get_primary_color());
+			kprintf("--Page %d-- (ESC/q/c/any key)", paginated_page); // Flushes
 			kbuf_wait_keydown(&ev);
 			if (ev.ascii == 27 || ev.ascii == 'q' || ev.ascii == 'Q') {
 				paginated_exit = true;
@@ -88,16 +97,16 @@ static void handle_newline()
 	}
 }
 
-void paginated_putch(uint8_t c)
+static void paginated_putch_buffered(uint8_t c)
 {
 	if (c == '\t') {
 		for (uint8_t i = 0; i < 8; i++)
-			paginated_putch(' ');
+			paginated_putch_buffered(' ');
 		return;
 	} else if (c == '\n') {
 		if (!paginated_suppress_lf) {
-			putch('\r');
-			putch('\n');
+			kputch('\r');
+			kputch('\n');
 			handle_newline();
 		}
 		paginated_suppress_lf = false;
@@ -105,9 +114,9 @@ void paginated_putch(uint8_t c)
 	} else {
 		if (c < 32 || c == 127) {
 			// escape it
-			putch(27);
+			kputch(27);
 		}
-		putch(c);
+		kputch(c);
 		paginated_col++;
 		if (paginated_col == scrcols) {
 			paginated_suppress_lf = true;
@@ -118,6 +127,12 @@ void paginated_putch(uint8_t c)
 	}
 }
 
+void paginated_putch(uint8_t c)
+{
+	paginated_putch_buffered(c);
+	kflush();
+}
+
 /**
  * Writes literal characters, not VDP control codes (only exception is \n)
  * Control codes will be escaped.
@@ -125,14 +140,15 @@ void paginated_putch(uint8_t c)
 void paginated_write(const char *buf, int len)
 {
 	for (int i = 0; i < len && !paginated_exit; i++) {
-		paginated_putch(buf[i]);
+		paginated_putch_buffered(buf[i]);
 	}
+	kflush();
 }
 
 static void _paginated_putch_wrapper(int c, void *data)
 {
 	(void)data;
-	paginated_putch(c);
+	paginated_putch_buffered(c);
 }
 
 void paginated_printf(const char *format, ...)
@@ -140,4 +156,6 @@ void paginated_printf(const char *format, ...)
 	va_list ap;
 	va_start(ap, format);
 	npf_vpprintf(&_paginated_putch_wrapper, NULL, format, ap);
+	va_end(ap);
+	kflush();
 }
@@ -21,6 +21,10 @@
 ; 03/08/2023:	Added user_kbvector
 ; 13/08/2023:	Added keymap
 ; 11/11/2023:	Added i2c
+; 16/10/2026:	Added UART0 receive ring counters
+; 16/10/2026:	Added vdp_bulk_ptr, vdp_bulk_size, vdp_bulk_cmd, vdp_bulk_len
+; 16/10/2026:	Added uart0Baud
+; 16/10/2026:	Added idleClock and cpuIdle
 
 			INCLUDE	"equs.inc"
 			
@@ -64,6 +68,13 @@
 			XDEF 	_callSM
 			XDEF	_scratchpad
 			XDEF	_keymap 
+			XDEF	_uart0RxOverruns
+			XDEF	_uart0RxDropped
+			XDEF	_uart0RxMaxPending
+			XDEF	_vdp_bulk_cmd
+			XDEF	_vdp_bulk_len
+			XDEF	_idleClock
+			XDEF	_cpuIdle
 
 			XDEF	_vpd_protocol_flags
 			XDEF	_vdp_protocol_state
@@ -71,12 +82,16 @@
 			XDEF	_vdp_protocol_len
 			XDEF	_vdp_protocol_ptr
 			XDEF	_vdp_protocol_data
+			XDEF	_vdp_bulk_ptr
+			XDEF	_vdp_bulk_size
 
 			XDEF	_user_kbvector
 
 			XDEF	_history_no
 			XDEF	_history_size
 
+			XDEF	_uart0Baud
+
 			XDEF	_i2c_slave_rw
 			XDEF	_i2c_error
 			XDEF	_i2c_role
@@ -133,6 +148,7 @@ _gp:			DS	1		; extern char _gp
 ;
 ; - Bit 0: UART0 enabled
 ; - Bit 1: UART0 hardware flow control
+; - Bit 2: UART0 receiving into the capture ring
 ; - Bit 4: UART1 enabled
 ; - Bit 5: UART1 hardware flow control
 ;
@@ -145,6 +161,22 @@ _scratchpad:		DS	8		; General purpose scratchpad RAM for use within functions
 ;
 _keymap:		DS	16		; A bitmap of pressed keys
 
+; UART0 receive counters
+;
+_uart0RxOverruns:	DS	2		; + 56h: Receive FIFO overruns
+_uart0RxDropped:	DS	2		; + 58h: Characters dropped because the receive ring was full
+_uart0RxMaxPending:	DS	1		; + 5Ah: Most characters waiting in the receive ring to be parsed
+
+; Long VDP packets
+;
+_vdp_bulk_cmd:		DS	1		; + 5Bh: Command byte of the last long packet received
+_vdp_bulk_len:		DS	1		; + 5Ch: Length of the last long packet received
+
+; CPU load
+;
+_idleClock:		DS	4		; + 5Dh: Centiseconds spent halted in idle_halt (sampled every VBLANK)
+_cpuIdle:		DS	1		; Set while idle_halt is halted
+
 ; VDP Protocol Flags
 ;
 ; Bit 0: Cursor packet received
@@ -154,7 +186,7 @@ _keymap:		DS	16		; A bitmap of pressed keys
 ; Bit 4: Mode packet received
 ; Bit 5: RTC packet received
 ; Bit 6: Mouse packet received
-; Bit 7: Unused
+; Bit 7: Long packet received into the caller's buffer
 ;
 ; VDP protocol variables
 ;
@@ -163,6 +195,8 @@ _vdp_protocol_cmd:	DS	1		; Command
 _vdp_protocol_len:	DS	1		; Size of packet data
 _vdp_protocol_ptr:	DS	3		; Pointer into data
 _vdp_protocol_data:	DS	VDPP_BUFFERLEN
+_vdp_bulk_ptr:		DS	3		; Caller's buffer for packets longer than VDPP_BUFFERLEN
+_vdp_bulk_size:		DS	1		; Size of the caller's buffer, or 0 if there isn't one
 
 ;
 ; Userspace hooks
@@ -181,3 +215,8 @@ _i2c_msg_size:		DS	1		; The (remaining) message size
 ;
 _history_no:		DS	1
 _history_size:		DS 	1
+
+; UART0 baud rate the ESP32 was locked onto. This is put back after the
+; section is reset in init.asm, so a warm boot can try it first
+;
+_uart0Baud:		DS	3
@@ -4,6 +4,7 @@
 #include "defines.h"
 
 // Declarations in globals.asm
+extern volatile uint32_t clock; // Centiseconds, incremented by 2 every VBLANK
 extern volatile uint8_t scrrows;
 extern volatile uint8_t scrcols;
 extern volatile uint8_t scrcolours;
@@ -18,6 +19,8 @@ extern volatile uint8_t keyascii;
 extern volatile uint8_t keydown;
 extern volatile uint8_t keycount;
 extern char hardReset; // 1 = hard cpu reset, 0 = soft reset
+extern uint24_t uart0Baud; // UART0 baud rate, kept over a warm boot
+extern volatile uint32_t idleClock; // Centiseconds of clock spent waiting in idle_halt
 extern uint8_t history_no;
 extern uint8_t history_size;
 
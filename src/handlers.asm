@@ -32,19 +32,63 @@ rst_18_handler:	LD	E, A 			; Preserve the delimiter
 			LD	A, MB			; Check if MBASE is 0
 			OR	A, A 
 			CALL	NZ, SET_AHL24		; No, so create a 24-bit pointer
+			PUSH	HL			; If rst 0x10 has been redirected then
+			PUSH	DE			; send the block through it a byte at a time
+			LD	HL, (ram_rst_10_handler + 1)
+			LD	DE, rst_10_handler
+			OR	A, A
+			SBC	HL, DE
+			POP	DE
+			POP	HL
+			JR	NZ, rst_18_handler_2
+			LD	A, B			; Check for BC = 0
+			OR	C 			; Yes, so run in delimited mode?
+			JR	NZ, rst_18_handler_0
+;
+; Delimited mode; find the length of the block first
+;
+			PUSH	HL
+1:			LD	A, (HL)			; Fetch the character
+			CP	E			; Is it the delimiter?
+			JR	Z, 2f			; Yes, so stop
+			INC	HL			; Increment the buffer pointer
+			INC	BC			; And the length
+			JR	1b
+2:			POP	HL
+			LD	A, B			; Is the block empty?
+			OR	C
+			RET.L	Z			; Yes, so nothing to do
+;
+; Standard loop mode; queue the whole block for the UART
+;
+rst_18_handler_0:	CALL	UART0_serial_WRITE
+			RET.L
+;
+; rst 0x10 has been redirected
+;
+rst_18_handler_2:	PUSH	HL			; If it is the framebuffer console then
+			PUSH	DE			; that can draw the whole block in one go
+			LD	HL, (ram_rst_10_handler + 1)
+			LD	DE, _fbconsole_rst10_handler
+			OR	A, A
+			SBC	HL, DE
+			POP	DE
+			POP	HL
+			LD	A, E
+			JP	Z, _fbconsole_rst18_handler
 			LD	A, B			; Check for BC = 0
 			OR	C 			; Yes, so run in delimited mode?
 			JR	Z, rst_18_handler_1
 ;
 ; Standard loop mode
 ;
-rst_18_handler_0:	LD 	A, (HL)			; Fetch the character
+rst_18_handler_3:	LD 	A, (HL)			; Fetch the character
 			RST.LIL 0x10			; Output
 			INC 	HL 			; Increment the buffer pointer
 			DEC	BC 			; Decrement the loop counter
 			LD	A, B 			; Is it 0?
 			OR 	C 
-			JR	NZ, rst_18_handler_0	; No, so loop
+			JR	NZ, rst_18_handler_3	; No, so loop
 			RET.L
 ;
 ; Delimited mode
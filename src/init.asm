@@ -141,6 +141,11 @@ __init:
 		ld hl, ___rodata_end
 		call ldir_handle_zerolen
 
+		; Keep the UART0 baud rate over the .bss reset, for a warm boot.
+		; After a cold boot RAM is all $ff, which is not a valid rate
+		ld hl, (_uart0Baud)
+		push hl
+
 		; clear .bss
 		ld hl, ___bss_start
 		ld de, ___bss_start + 1
@@ -148,6 +153,9 @@ __init:
 		ld (hl), 0
 		call ldir_handle_zerolen
 
+		pop hl			; Put the UART0 baud rate back
+		ld (_uart0Baud), hl
+
 		pop af			; Pop the hardReset value
 		ld (_hardReset), a	; And store
 
@@ -8,6 +8,11 @@
 ; 09/03/2023:	No longer uses timer interrupt 0 for SD card timing
 ; 29/03/2023:	Added support for UART1
 ; 10/11/2023:	Added support for I2C
+; 16/10/2026:	UART0 transmit interrupt drains the transmit ring
+; 16/10/2026:	UART0 receive interrupt only fills the receive ring; packets are parsed with interrupts enabled
+; 16/10/2026:	Added UART1 interrupt handler
+; 16/10/2026:	_uart0_rx_parsing can be set to leave the UART0 receive ring to a reader outside the handler
+; 16/10/2026:	Vertical blank interrupt counts idleClock while idle_halt is halted
 
 			INCLUDE	"macros.inc"
 			INCLUDE	"equs.inc"
@@ -19,13 +24,23 @@
 			
 			XDEF	_vblank_handler
 			XDEF	_uart0_handler
+			XDEF	_uart1_handler
+			XDEF	_uart0_rx_parsing
 			XDEF	_i2c_handler
 
 			XREF	_clock
+			XREF	_idleClock
+			XREF	_cpuIdle
 			XREF	_vdp_protocol_data
 			
 			XREF	UART0_serial_RX
 			XREF	UART0_serial_TX
+			XREF	UART0_TX_pump
+			XREF	UART0_RX_drain
+			XREF	UART0_RX_get
+			XREF	UART1_TX_pump
+			XREF	UART1_RX_drain
+			XREF	_serialFlags
 			XREF	mos_api
 			XREF	vdp_protocol			
 			
@@ -50,7 +65,23 @@ _vblank_handler:
 			LD		A, (_clock + 3)
 			ADC		A, 0
 			LD		(_clock + 3), A			
-			POP		HL
+			LD		A, (_cpuIdle)		; Was the CPU waiting in idle_halt?
+			OR		A, A
+			JR		Z, 2f
+			LD		HL, (_idleClock)	; Yes, so count this tick as idle
+			ADD		HL, BC
+			LD		(_idleClock), HL
+			LD		A, (_idleClock + 3)
+			ADC		A, 0
+			LD		(_idleClock + 3), A
+2:			CALL		UART0_TX_pump		; Restart UART0 sending if flow control stalled it
+			LD		A, (_serialFlags)	; And UART1, if it is open
+			TST		10h
+			JR		Z, 1f
+			PUSH		IX
+			CALL		UART1_TX_pump
+			POP		IX
+1:			POP		HL
 			POP		DE
 			POP		BC
 			POP		AF
@@ -62,20 +93,69 @@ _vblank_handler:
 _uart0_handler:		
 			DI
 			PUSH		AF
+			XOR		A, A			; Packets are parsed in here with interrupts
+			LD		(_cpuIdle), A		; enabled, so this is not idle time
 			PUSH		BC
 			PUSH		DE
 			PUSH		HL
-			CALL		UART0_serial_RX
+			IN0		A, (UART0_IIR)		; Transmit FIFO empty?
+			AND		0Eh
+			CP		02h
+			JR		NZ, 1f
+			CALL		UART0_TX_pump		; Yes, so refill it from the ring
+			JR		3f
+1:			CALL		UART0_RX_drain		; Empty the receive FIFO into the ring
+			LD		HL, _uart0_rx_parsing	; Is the ring already being parsed further
+			LD		A, (HL)			; down the stack?
+			OR		A, A
+			JR		NZ, 3f			; Yes, so leave it to that
+			INC		(HL)
+			EI					; Parse with interrupts enabled, so the
+2:			CALL		UART0_RX_get		; FIFO can be emptied again meanwhile
+			JR		NC, 4f
 			LD		C, A		
 			LD		HL, _vdp_protocol_data
 			CALL		vdp_protocol
-			POP		HL
+			JR		2b
+4:			DI					; Check again, in case a character
+			CALL		UART0_RX_get		; arrived after the ring was emptied
+			JR		NC, 5f
+			EI
+			LD		C, A		
+			LD		HL, _vdp_protocol_data
+			CALL		vdp_protocol
+			JR		2b
+5:			XOR		A, A
+			LD		(_uart0_rx_parsing), A
+3:			POP		HL
 			POP		DE
 			POP		BC
 			POP		AF
 			EI
 			RETI.L	
 
+; AGON UART1 Interrupt Handler
+; Received characters go into the receive ring, and the transmit ring is
+; drained into the FIFO; see UART1_RX_drain and UART1_TX_pump in serial.asm
+;
+_uart1_handler:
+			DI
+			PUSH		AF
+			PUSH		BC
+			PUSH		DE
+			PUSH		HL
+			PUSH		IX
+			IN0		A, (UART1_IIR)		; Acknowledge the interrupt
+			CALL		UART1_RX_drain		; Empty the receive FIFO into the ring
+			CALL		UART1_TX_pump		; Refill the transmit FIFO from the ring
+			POP		IX
+			POP		HL
+			POP		DE
+			POP		BC
+			POP		AF
+			EI
+			RETI.L
+
 ; AGON I2C Interrupt handler
 ;
 _i2c_handler:
@@ -284,5 +364,10 @@ i2c_sendstop:
 			POP		AF
 			EI
 			RETI.L
+
+			.bss
+
+_uart0_rx_parsing:	DS	1			; Non-zero while the UART0 receive ring is being parsed,
+							; or while something else is reading it (see sideload.c)
 	
 			END
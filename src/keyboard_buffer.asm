@@ -2,16 +2,52 @@
 		.text
 		.global _kbuf_poll_event
 		.global _kbuf_wait_keydown
+		.extern idle_halt
+		.extern _aread_service
 		.global _kbuf_clear
+		.global _kbuf_set_buffer
+		.global _kbuf_stats
 		.global kbuf_append
 		.global kbuf_remove
+		.global kbuf_remove_ex
 		.global kbuf_isempty
 
+; Each event in the ring is the 4-byte packet from the VDP, followed by the
+; 32-bit _clock when it arrived. The ring starts out in kbbuf_default, and
+; kbuf_set_buffer can move it to a larger one
+KBBUF_LEN: 	.equ 32		; events in kbbuf_default. must be <256
+KBBUF_EVENT_LEN: .equ 8
+
 _kbuf_wait_keydown:
 		push ix
 		ld ix,0
 		add ix,sp
 	.try:
+		; do a slice of any queued file reads, then if there were none,
+		; sleep until there is an event. the check is done with
+		; interrupts disabled, so one arriving after it wakes idle_halt
+		call _aread_service
+		ld c,a		; c: nonzero if there was a read to do
+		ld a,i		; p/v: iff2, so whether interrupts are enabled
+		di
+		push af
+		call kbuf_isempty
+		jr nz,.ready
+		pop af
+		jp po,.try	; they are disabled, so all we can do is poll
+		ld a,c
+		or a,a
+		jr z,.sleep
+		ei		; there may be more reads to do, so look again
+		jr .try
+	.sleep:
+		call idle_halt
+		jr .try
+	.ready:
+		pop af
+		jp po,1f
+		ei
+	1:
 		ld de,(ix+6)
 		call kbuf_remove	
 		jr z,.try
@@ -43,22 +79,28 @@ _kbuf_poll_event:
 		ret
 
 kbuf_append:	; 4-byte value to append in (de). set `z` if no space
-		; put (de)..(de+3) to kbbuf_data[kbbuf_end_idx*4]
-		ld hl,0
+		; put (de)..(de+3) and _clock to the entry at kbbuf_end_idx
 		ld a,(kbbuf_end_idx)
-		ld l,a
-		add hl,hl
-		add hl,hl
-		ld bc,kbbuf_data
-		add hl,bc
+		call kbuf_entry
 
 		ex de,hl
 		ld bc,4
 		ldir
+		ld hl,_clock	; with interrupts disabled, so a vblank
+		ld bc,4		; can't tick the clock part way through
+		ld a,i		; p/v: iff2, so whether interrupts are enabled
+		di
+		push af
+		ldir
+		pop af
+		jp po,4f	; they were disabled, so leave them that way
+		ei
+	4:
 
 		ld a,(kbbuf_end_idx)
 		inc a
-		cp KBBUF_LEN
+		ld hl,kbbuf_len
+		cp (hl)
 		jr nz,1f
 		xor a
 	1:
@@ -68,28 +110,56 @@ kbuf_append:	; 4-byte value to append in (de). set `z` if no space
 		cp c
 
 		; if kbbuf_start_idx==kbbuf_end_idx+1 then no space for appending
-		ret z
+		jr z,3f
 		
 		; otherwise write new kbbuf_end_idx
 		ld a,c
 		ld (kbbuf_end_idx),a
+
+		; and keep track of the most events that have been waiting at once
+		ld hl,kbbuf_start_idx
+		sub (hl)
+		jr nc,2f
+		ld hl,kbbuf_len
+		add a,(hl)
+	2:
+		ld hl,kbbuf_max_pending
+		cp (hl)
+		jr c,2f
+		ld (hl),a
+	2:
+		or 1		; clear `z` flag
+		ret
+
+	3:	; the event is lost, so count it
+		ld hl,(kbbuf_dropped)
+		inc hl
+		ld (kbbuf_dropped),hl
+		xor a		; set `z` flag
 		ret
 
 ; Take 1 event from the keyboard buffer (store to (de) struct keyboard_event_t*)
 kbuf_remove:	; remove 4-byte value into (de)..(de+3). `z` flag set if no bytes in fifo
+		ld bc,4
+		jr 1f
+
+; Take 1 event and its timestamp (store to (de) struct keyboard_event_ex_t*)
+kbuf_remove_ex:	; remove 8-byte value into (de)..(de+7). `z` flag set if no bytes in fifo
+		ld bc,KBBUF_EVENT_LEN
+	1:
 		call kbuf_isempty
 		ret z
 
-		add hl,hl
-		add hl,hl
-		ld bc,kbbuf_data
-		add hl,bc
-		ld bc,4
+		push bc
+		ld a,l
+		call kbuf_entry
+		pop bc
 		ldir
 
 		ld a,(kbbuf_start_idx)
 		inc a
-		cp KBBUF_LEN
+		ld hl,kbbuf_len
+		cp (hl)
 		jr nz,1f
 		xor a
 	1:
@@ -98,6 +168,16 @@ kbuf_remove:	; remove 4-byte value into (de)..(de+3). `z` flag set if no bytes i
 		or 1		; clear `z` flag
 		ret
 
+kbuf_entry:	; hl = address of entry `a` in the ring. corrupts bc
+		ld hl,0
+		ld l,a
+		add hl,hl
+		add hl,hl
+		add hl,hl
+		ld bc,(kbbuf_data)
+		add hl,bc
+		ret
+
 kbuf_isempty:	; 'z' flag set if key buffer is empty
 		ld hl,0
 		ld a,(kbbuf_start_idx)
@@ -112,8 +192,56 @@ _kbuf_clear:
 		ld (kbbuf_start_idx),a
 		ret
 
+; Move the keyboard buffer to a new ring, discarding any events waiting in it
+; void *kbuf_set_buffer(struct keyboard_event_ex_t *buf, uint8_t len)
+; - buf: room for len events, or NULL to go back to kbbuf_default
+; Returns the old ring, or NULL if that was kbbuf_default
+_kbuf_set_buffer:
+		push ix
+		ld ix,0
+		add ix,sp
+
+		ld de,(ix+6)
+		ld c,(ix+9)
+		ld hl,0
+		or a
+		sbc hl,de
+		jr nz,1f
+		ld de,kbbuf_default
+		ld c,KBBUF_LEN
+	1:
+		ld a,i		; p/v: iff2, so whether interrupts are enabled
+		di
+		push af
+		ld hl,(kbbuf_data)
+		ld (kbbuf_data),de
+		ld a,c
+		ld (kbbuf_len),a
+		xor a
+		ld (kbbuf_start_idx),a
+		ld (kbbuf_end_idx),a
+		ld (kbbuf_max_pending),a
+		pop af
+		jp po,1f	; they were disabled, so leave them that way
+		ei
+	1:
+		ld de,kbbuf_default
+		or a
+		sbc hl,de
+		jr z,1f
+		add hl,de
+	1:
+		pop ix
+		ret
+
+		.data
+kbbuf_data:		.d24 kbbuf_default	; the ring in use
+_kbuf_stats:		; reported by mos_api_kbufstats
+kbbuf_dropped:		.d24 0			; events lost because the ring was full
+kbbuf_len:		db KBBUF_LEN		; entries in the ring
+kbbuf_max_pending:	db 0			; most events waiting in the ring at once
+
 		.bss
-KBBUF_LEN: 	.equ 32		; must be <256
 kbbuf_start_idx:	db 0
 kbbuf_end_idx: 		db 0
-kbbuf_data:		ds KBBUF_LEN*4
+kbbuf_default:		ds KBBUF_LEN*KBBUF_EVENT_LEN
@@ -10,8 +10,22 @@ struct __attribute__((packed)) keyboard_event_t {
 	uint8_t isdown;
 };
 
+struct __attribute__((packed)) keyboard_event_ex_t {
+	struct keyboard_event_t ev;
+	uint32_t time; // clock when the event arrived, in centiseconds
+};
+
+typedef struct {
+	uint24_t dropped;    // Events lost because the ring was full
+	uint8_t len;	     // Entries in the ring, which holds one fewer events
+	uint8_t max_pending; // Most events that have waited in the ring at once
+} t_kbufStats;
+
+extern t_kbufStats kbuf_stats;
+
 extern bool kbuf_poll_event(struct keyboard_event_t *e);
 extern void kbuf_wait_keydown(struct keyboard_event_t *e);
 extern void kbuf_clear(void);
+extern void *kbuf_set_buffer(struct keyboard_event_ex_t *buf, uint8_t len);
 
 #endif /* KEYBOARD_BUFFER_H */
@@ -27,6 +27,8 @@
  * 03/08/2023:				RC2	+ Enhanced low-level keyboard functionality
  * 27/09/2023:					+ Updated RTC
  * 11/11/2023:				RC3	+ See Github for full list of changes
+ * 16/10/2026:					+ Baud rate picked from a table, verified, and reused on warm boot
+ * 16/10/2026:					+ UART1 interrupt handler
  */
 
 #include "defines.h"
@@ -53,18 +55,24 @@ extern void *set_vector(unsigned int vector, void (*handler)(void));
 
 extern void vblank_handler(void);
 extern void uart0_handler(void);
+extern void uart1_handler(void);
 extern void i2c_handler(void);
 
 extern bool vdpSupportsTextPalette;
 
+// UART0 baud rates to try when locking onto the ESP32, fastest first
+// 1152000 is a divisor of 1 from the 18.432MHz clock, so is as fast as UART0 can go
+//
+static const uint24_t uart0BaudRates[] = { 1152000, 384000 };
+
 // Wait for the ESP32 to respond with a GP packet to signify it is ready
 // Parameters:
-// - pUART: Pointer to a UART structure
 // - baudRate: Baud rate to initialise UART with
+// - timeout: How long to keep trying, in 50ms steps
 // Returns:
 // - 1 if the function succeeded, otherwise 0
 //
-int wait_ESP32(uint24_t baudRate)
+int wait_ESP32(uint24_t baudRate, int timeout)
 {
 	UART UART0;
 	int i, t;
@@ -76,10 +84,12 @@ int wait_ESP32(uint24_t baudRate)
 	UART0.flowControl = FCTL_HW;
 	UART0.interrupts = UART_IER_RECEIVEINT;
 
-	open_UART0(&UART0);		  // Open the UART
+	if (open_UART0(&UART0) != UART_ERR_NONE) { // Open the UART
+		return 0;
+	}
 	init_timer0(10, 16, 0x00);	  // 10ms timer for delay
 	gp = 0;				  // Reset the general poll byte
-	for (t = 0; t < 200; t++) {	  // A timeout loop (200 x 50ms = 10s)
+	for (t = 0; t < timeout; t++) {	  // A timeout loop (timeout x 50ms)
 		putch(23);		  // Send a general poll packet
 		putch(0);
 		putch(VDP_gp);
@@ -93,12 +103,66 @@ int wait_ESP32(uint24_t baudRate)
 	return gp;
 }
 
+// Check the link to the ESP32 with a few more general polls, each echoing
+// a different byte, so a rate that only just works isn't kept
+// Returns:
+// - true if they all came back
+//
+static bool verify_ESP32()
+{
+	static const uint8_t pattern[] = { 0x55, 0xAA, 0x0F, 0xF0 };
+	bool ok = true;
+
+	for (int i = 0; ok && i < (int)sizeof(pattern); i++) {
+		const uint32_t start = clock;
+		putch(23);
+		putch(0);
+		putch(VDP_gp);
+		putch(pattern[i]);
+		while (gp != (char)pattern[i] && clock - start < 10) { }
+		ok = gp == (char)pattern[i];
+	}
+	gp = ok ? 1 : 0;
+	return ok;
+}
+
+// Lock onto the ESP32 at the fastest baud rate that works
+// On a warm boot the VDP hasn't been reset, so the rate it was left at is tried first
+// Returns:
+// - true if the ESP32 responded
+//
+static bool lock_ESP32()
+{
+	int i;
+	const int n = sizeof(uart0BaudRates) / sizeof(uart0BaudRates[0]);
+
+	if (hardReset == 0) {
+		for (i = 0; i < n; i++) {
+			if (uart0BaudRates[i] == uart0Baud) {
+				if (wait_ESP32(uart0Baud, 10) && verify_ESP32()) {
+					return true;
+				}
+				break;
+			}
+		}
+	}
+	for (i = 0; i < n; i++) {
+		if (wait_ESP32(uart0BaudRates[i], 200) && verify_ESP32()) {
+			uart0Baud = uart0BaudRates[i];
+			return true;
+		}
+	}
+	uart0Baud = 0;
+	return false;
+}
+
 // Initialise the interrupts
 //
 static void init_interrupts(void)
 {
 	set_vector(PORTB1_IVECT, vblank_handler); // 0x32
 	set_vector(UART0_IVECT, uart0_handler);	  // 0x18
+	set_vector(UART1_IVECT, uart1_handler);	  // 0x1A
 	set_vector(I2C_IVECT, i2c_handler);	  // 0x1C
 }
 
@@ -133,10 +197,8 @@ int main(void)
 	init_fbterm();
 	asm volatile("ei");
 
-	if (!wait_ESP32(1152000)) {	   // Try to lock onto the ESP32 at maximum rate
-		if (!wait_ESP32(384000)) { // If that fails, then fallback to the lower baud rate
-			gp = 2;		   // Flag GP as 2, just in case we need to handle this error later
-		}
+	if (!lock_ESP32()) {		   // Try to lock onto the ESP32 at the fastest rate that works
+		gp = 2;			   // Flag GP as 2, just in case we need to handle this error later
 	}
 	if (hardReset == 0) {
 		// clear screen on soft reset, since VDP has not been reset
@@ -171,7 +233,7 @@ int main(void)
 //
 #if enable_config == 1
 	{
-		int err = mos_EXEC("autoexec.txt", cmd, sizeof cmd);	// Then load and run the config file
+		int err = mos_EXEC("autoexec.txt", cmd, sizeof cmd, false);	// Then load and run the config file
 		if (err > 0 && err != FR_NO_FILE) {
 			mos_error(err);
 		}
@@ -180,7 +242,7 @@ int main(void)
 
 #ifdef FEAT_FRAMEBUFFER
 	{
-		int err = mos_EXEC("/mos/fbinit.bat", cmd, sizeof cmd); // Then load and run the config file
+		int err = mos_EXEC("/mos/fbinit.bat", cmd, sizeof cmd, false); // Then load and run the config file
 		if (err > 0 && err != FR_NO_FILE) {
 			mos_error(err);
 		}
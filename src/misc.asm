@@ -12,6 +12,9 @@
 ; 09/03/2023:	Added wait_timer0
 ; 20/03/2023:	Function exec24 now preserves MB
 ; 15/04/2023:	Added GET_AHL24
+; 16/10/2026:	Added wait_event
+; 16/10/2026:	Added idle_halt
+; 16/10/2026:	wait_event does a slice of any queued asynchronous reads before sleeping
 
 			INCLUDE	"macros.inc"
 			INCLUDE	"equs.inc"
@@ -35,8 +38,12 @@
 			XDEF	_exec24
 			XDEF	_wait_timer0
 			XDEF	_timer0_delay
+			XDEF	_wait_event
+			XDEF	idle_halt
 
 			XREF	_callSM
+			XREF	_cpuIdle
+			XREF	_aread_service
 			XREF	kbuf_clear
 
 ; Switch on A - lookup table immediately after call
@@ -217,6 +224,73 @@ _wait_timer0:		PUSH	AF
 			POP	AF 
 			RET
 
+; uint8_t wait_event(volatile uint8_t * flags, uint8_t mask);
+;
+; Check for an event, and if it hasn't happened, do a slice of any queued
+; asynchronous file reads, or if there are none, sleep until the next interrupt
+; The check is done with interrupts disabled, and EI HALT re-enables them only
+; as the CPU halts, so an interrupt that comes in after the check still wakes it
+; If interrupts are disabled on entry, then it just checks, and says so, as
+; neither the flags nor the clock can change until they are enabled again
+; Parameters:
+; - flags: Pointer to the event flags
+; - mask: The flags to check for
+; Returns:
+; - WAIT_EVENT_SET (1) if any of the flags were set
+; - WAIT_EVENT_NONE (0) if not, after sleeping until an interrupt or reading
+; - WAIT_EVENT_POLLED (2) if not, and interrupts are disabled
+;
+_wait_event:		PUSH	IY			; Standard C prologue
+			LD	IY, 0
+			ADD	IY, SP
+			LD	HL, (IY+6)		; volatile uint8_t * flags
+			LD	A, (HL)			; Already set?
+			AND	A, (IY+9)		; uint8_t mask
+			JR	NZ, 3f
+			PUSH	IY
+			CALL	_aread_service		; No, so do a slice of any queued file reads
+			POP	IY
+			OR	A, A			; If there was one, that will do for a wait
+			JR	NZ, 5f
+			LD	HL, (IY+6)		; volatile uint8_t * flags
+			LD	A, I			; P/V: Whether interrupts are enabled
+			PUSH	AF
+			DI
+			LD	A, (HL)			; Check the flags
+			AND	A, (IY+9)		; uint8_t mask
+			JR	NZ, 2f
+			POP	AF			; Not set, so if interrupts are enabled
+			JP	PO, 1f
+			CALL	idle_halt		; then sleep until the next one
+5:			XOR	A, A			; Return WAIT_EVENT_NONE
+			JR	4f
+1:			LD	A, 2			; Return WAIT_EVENT_POLLED
+			JR	4f
+2:			POP	AF			; Set, so re-enable interrupts if they were
+			JP	PO, 3f
+			EI
+3:			LD	A, 1			; And return WAIT_EVENT_SET
+4:			LD	SP, IY			; Standard epilogue
+			POP	IY
+			RET
+
+; Sleep until the next interrupt (UART0, vertical blank, I2C...)
+; Call with interrupts disabled, straight after finding there is nothing to do yet
+; EI HALT re-enables them only as the CPU halts, so an interrupt that came in
+; after the check still wakes it. The vertical blank handler counts the time in
+; idleClock while cpuIdle is set
+; Returns with interrupts enabled
+; Corrupts:
+; - A
+;
+idle_halt:		LD	A, 1
+			LD	(_cpuIdle), A
+			EI
+			HALT
+			XOR	A, A
+			LD	(_cpuIdle), A
+			RET
+
 _timer0_delay:
 			POP		HL
 			POP		BC
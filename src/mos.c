@@ -35,6 +35,10 @@
  * 26/09/2023:		Refactored mos_GETRTC and mos_SETRTC
  * 10/11/2023:		Added CONSOLE to mos_cmdSET
  * 11/11/2023:		Added mos_cmdHELP, mos_cmdTYPE, mos_cmdCLS, mos_cmdMOUNT, mos_mount
+ * 16/10/2026:		Added SIDELOAD -b and SIDELOAD <filename>
+ * 16/10/2026:		Added SET KEYBUF and mos_KBUFSIZE, MEM shows keyboard buffer statistics
+ * 16/10/2026:		MEM shows the time spent idle
+ * 16/10/2026:		File calls that use the file pointer are refused while asynchronous reads are queued on it
  */
 
 #include "defines.h"
@@ -52,7 +56,11 @@
 #include "keyboard_buffer.h"
 #include "mos.h"
 #include "mos_editor.h"
+#include "async_read.h"
+#include "pool.h"
+#include "sideload.h"
 #include "strings.h"
+#include "timer.h"
 #include "uart.h"
 #ifdef FEAT_FRAMEBUFFER
 #include "fbconsole.h"
@@ -79,10 +87,31 @@ static char *mos_strtok_ptr;					     // Pointer for current position in string
 char *cwd;							     // Hold current working directory.
 bool sdcardDelay = false;
 
-static FIL *mosFileObjects[MOS_maxOpenFiles];
+// Open files by handle - 1. The table grows on demand, up to MOS_maxOpenFiles
+// handles. Also read by the FGETC/FPUTC fast path in mos_api.asm
+FIL **mosFileObjects;
+uint8_t mosFileObjects_count;
+
+// The FIL objects for open files
+static Pool filPool = { NULL, sizeof(FIL), MOS_filesPerSlab, 0, 0, 0 };
+
+// With FF_FS_TINY every open file reads and writes through the shared sector
+// window in fs. mos_api.asm serves FGETC/FPUTC from it directly while the
+// file's current sector is there, only calling FatFS at sector boundaries
+BYTE *const mos_fsWin = fs.win;		// The sector window
+LBA_t *const mos_fsWinSect = &fs.winsect; // Sector number held in the window
+BYTE *const mos_fsWFlag = &fs.wflag;	// Set to mark the window dirty
 
 bool vdpSupportsTextPalette = false;
 
+// A line of a batch file, as split up by mos_EXEC
+typedef struct {
+	char *text;		 // The zero terminated line, in the script buffer
+	const t_mosCommand *cmd; // Cached command lookup, or MOS_CMD_UNRESOLVED
+} t_mosExecLine;
+
+#define MOS_CMD_UNRESOLVED ((const t_mosCommand *)-1)
+
 // Array of MOS commands and pointer to the C function to run
 // NB this list is iterated over, so the order is important
 // for the help command
@@ -118,7 +147,7 @@ static const t_mosCommand mosCommands[] = {
 	{ "RM", &mos_cmdDEL, HELP_DELETE_ARGS, HELP_DELETE },
 	{ "RUN", &mos_cmdRUN, HELP_RUN_ARGS, HELP_RUN },
 	{ "SAVE", &mos_cmdSAVE, HELP_SAVE_ARGS, HELP_SAVE },
-	{ "SIDELOAD", &mos_cmdSIDELOAD, NULL, NULL },
+	{ "SIDELOAD", &mos_cmdSIDELOAD, HELP_SIDELOAD_ARGS, HELP_SIDELOAD },
 	{ "SET", &mos_cmdSET, HELP_SET_ARGS, HELP_SET },
 	{ "TIME", &mos_cmdTIME, HELP_TIME_ARGS, HELP_TIME },
 	{ "TYPE", &mos_cmdTYPE, HELP_TYPE_ARGS, HELP_TYPE },
@@ -404,13 +433,15 @@ int mos_runBin(uint24_t addr)
 	}
 }
 
-// Execute a MOS command
+// Execute a MOS command, caching the command table lookup
 // Parameters:
 // - buffer: Pointer to a zero terminated string that contains the MOS command with arguments
+// - cache: Where to cache the lookup of this command, or NULL for no caching.
+//          Set to MOS_CMD_UNRESOLVED before the first call
 // Returns:
 // - MOS error code
 //
-int mos_exec(char *buffer, bool in_mos)
+static int mos_execCached(char *buffer, bool in_mos, const t_mosCommand **cache)
 {
 	char *ptr;
 	int fr = 0;
@@ -426,7 +457,14 @@ int mos_exec(char *buffer, bool in_mos)
 	ptr = mos_strtok(ptr, " ");
 	if (ptr == NULL) return fr;
 
-	cmd = mos_getCommand(ptr);
+	if (cache == NULL) {
+		cmd = mos_getCommand(ptr);
+	} else {
+		if (*cache == MOS_CMD_UNRESOLVED) {
+			*cache = mos_getCommand(ptr);
+		}
+		cmd = *cache;
+	}
 	if (cmd != NULL && cmd->func != 0) {
 		return cmd->func(ptr);
 	}
@@ -474,6 +512,17 @@ int mos_exec(char *buffer, bool in_mos)
 	return fr;
 }
 
+// Execute a MOS command
+// Parameters:
+// - buffer: Pointer to a zero terminated string that contains the MOS command with arguments
+// Returns:
+// - MOS error code
+//
+int mos_exec(char *buffer, bool in_mos)
+{
+	return mos_execCached(buffer, in_mos, NULL);
+}
+
 // Get the MOS Z80 execution mode
 // Parameters:
 // - ptr: Pointer to the code block
@@ -667,8 +716,9 @@ int mos_cmdLOAD(char *ptr)
 	return fr;
 }
 
-// EXEC <filename>
+// EXEC [-v] <filename>
 //   Run a batch file containing MOS commands
+//   -v echoes each line and how long it took to run
 // Parameters:
 // - ptr: Pointer to the argument string in the line edit buffer
 // Returns:
@@ -678,16 +728,22 @@ int mos_cmdEXEC(char *ptr)
 {
 	FRESULT fr;
 	char *filename;
-	uint24_t addr;
+	bool verbose = false;
 	char buf[256];
 
 	DEBUG_STACK();
 
-	if (
-	    !mos_parseString(NULL, &filename)) {
-		return FR_INVALID_PARAMETER;
+	for (;;) {
+		if (!mos_parseString(NULL, &filename)) {
+			return FR_INVALID_PARAMETER;
+		}
+		if (strcasecmp(filename, "-v") == 0) {
+			verbose = true;
+		} else {
+			break;
+		}
 	}
-	fr = mos_EXEC(filename, buf, sizeof buf);
+	fr = mos_EXEC(filename, buf, sizeof buf, verbose);
 	return fr;
 }
 
@@ -984,6 +1040,9 @@ int mos_cmdSET(char *ptr)
 		putch(value & 0xFF);
 		return 0;
 	}
+	if (strcasecmp(command, "KEYBUF") == 0 && value <= 254) {
+		return mos_KBUFSIZE(value ? value + 1 : 0);
+	}
 	return FR_INVALID_PARAMETER;
 }
 
@@ -1119,7 +1178,19 @@ int mos_cmdMEM(char *ptr)
 	}
 
 	kprintf("Largest free MOS:HEAP fragment: %d b\r\n", try_len);
+	kprintf("Open files: %d (peak %d, %d handles of %d)\r\n", filPool.in_use, filPool.peak_in_use, mosFileObjects_count, MOS_maxOpenFiles);
 	kprintf("Sysvars at &%06x\r\n", (uint24_t)sysvars);
+	kprintf("VDP waits: %d (%d timed out), %d.%02ds in total, longest %d.%02ds\r\n", vdp_wait_stats.requests, vdp_wait_stats.timeouts,
+	    (int)(vdp_wait_stats.total / 100), (int)(vdp_wait_stats.total % 100), vdp_wait_stats.longest / 100, vdp_wait_stats.longest % 100);
+	{
+		const uint32_t up = clock;
+		const uint32_t idle = idleClock;
+
+		// idle * 100 / up would overflow after about 46 hours, so from then on
+		// divide by up / 100 instead, which is just as accurate by then
+		kprintf("CPU idle: %d%% since boot\r\n", up == 0 ? 0 : (int)(up < 0x1000000 ? idle * 100 / up : idle / (up / 100)));
+	}
+	kprintf("Keyboard events: %d dropped, at most %d of %d buffered\r\n", kbuf_stats.dropped, kbuf_stats.max_pending, kbuf_stats.len - 1);
 #ifdef DEBUG
 	kprintf("Stack highwatermark: &%06x (%d b)\r\n", stack_highwatermark, (uint24_t)_stack - stack_highwatermark);
 #endif /* DEBUG */
@@ -1143,16 +1214,18 @@ int mos_cmdMEMDUMP(char *ptr)
 	paginated_start(true);
 
 	while (i < len) {
-		paginated_printf("%06x:", addr + i);
+		char line[96]; // Each line is built here, and written out in one go
+		int n = ksnprintf(line, sizeof(line), "%06x:", addr + i);
 		for (int c = 0; c < width; c++) {
-			if ((c & 3) == 0) putch(' ');
-			paginated_printf("%02x", *(uint8_t *)(addr + i + c));
+			if ((c & 3) == 0) line[n++] = ' ';
+			n += ksnprintf(line + n, sizeof(line) - n, "%02x", *(uint8_t *)(addr + i + c));
 		}
-		putch(' ');
+		line[n++] = ' ';
 		for (int c = 0; c < width; c++) {
-			putch(27);
-			putch(*(uint8_t *)(addr + i + c));
+			line[n++] = 27;
+			line[n++] = *(uint8_t *)(addr + i + c);
 		}
+		putblock(line, n);
 		paginated_printf("\r\n");
 		if (paginated_exit) break;
 		i += width;
@@ -1890,36 +1963,82 @@ uint24_t mos_COPY_API(char *srcPath, char *dstPath)
 	return mos_COPY(srcPath, dstPath, false);
 }
 
+// Allocate a transfer buffer for copy_file
+// Tries for a whole cluster, halving the size until the heap can satisfy it.
+// The size is always a multiple of the sector size, so f_read and f_write
+// move whole sectors straight between the card and the buffer
+// Parameters:
+// - size: Pointer to receive the size of the buffer
+// Returns:
+// - Pointer to the buffer, or NULL if not even one sector is free
+//
+static uint8_t *alloc_copy_buffer(UINT *size)
+{
+	UINT len = (UINT)fs.csize * FF_MAX_SS;
+	uint8_t *buffer;
+
+	for (; len >= FF_MAX_SS; len >>= 1) {
+		buffer = umm_malloc(len);
+		if (buffer) {
+			*size = len;
+			return buffer;
+		}
+	}
+	return NULL;
+}
+
 static FRESULT copy_file(char *srcPath, char *destPath, bool verbose)
 {
 	FIL fsrc, fdst;
 	FRESULT fr;
-	uint8_t buffer[512];
-	UINT br, bw;
+	uint8_t *buffer;
+	UINT len, br, bw;
+	FSIZE_t size;
 
 	DEBUG_STACK();
 
+	buffer = alloc_copy_buffer(&len);
+	if (buffer == NULL) {
+		return FR_NOT_ENOUGH_CORE;
+	}
+
 	fr = f_open(&fsrc, srcPath, FA_READ);
 	if (fr != FR_OK) {
+		umm_free(buffer);
 		return fr;
 	}
 	fr = f_open(&fdst, destPath, FA_WRITE | FA_CREATE_NEW);
 	if (fr != FR_OK) {
 		f_close(&fsrc);
+		umm_free(buffer);
 		return fr;
 	}
 
 	if (verbose) kprintf("Copying %s to %s\r\n", srcPath, destPath);
-	while (1) {
-		fr = f_read(&fsrc, buffer, sizeof(buffer), &br);
+
+	// Preallocate the destination cluster chain in one go, by seeking past
+	// the end of the new file, so the copy fails early if the disk is full
+	size = f_size(&fsrc);
+	if (size > 0) {
+		fr = f_lseek(&fdst, size);
+		if (fr == FR_OK && f_tell(&fdst) != size) fr = FR_DENIED;
+		if (fr == FR_OK) fr = f_lseek(&fdst, 0);
+	}
+
+	while (fr == FR_OK) {
+		fr = f_read(&fsrc, buffer, len, &br);
 		if (br == 0 || fr != FR_OK) break;
 		fr = f_write(&fdst, buffer, br, &bw);
-		if (bw < br || fr != FR_OK) break;
+		if (fr == FR_OK && bw < br) fr = FR_DENIED;
 	}
 	f_close(&fsrc);
 	f_close(&fdst);
+	umm_free(buffer);
+	if (fr != FR_OK) {
+		f_unlink(destPath); // Don't leave a partial copy, or the preallocated file, behind
+	}
 
-	return 0;
+	return fr;
 }
 
 // Copy file
@@ -2026,36 +2145,187 @@ uint24_t mos_MKDIR(char *filename)
 	return fr;
 }
 
+// Split a zero terminated chunk of a batch file into lines
+// Line endings (LF or CR LF) are overwritten with terminators
+// Parameters:
+// - text: The chunk to split
+// - lines: Array to fill in, or NULL to just count the lines without modifying the text
+// Returns:
+// - Number of lines
+//
+static int exec_splitLines(char *text, t_mosExecLine *lines)
+{
+	char *eol;
+	int n = 0;
+
+	while (*text) {
+		eol = strchr(text, '\n');
+		if (lines) {
+			lines[n].text = text;
+			lines[n].cmd = MOS_CMD_UNRESOLVED;
+			if (eol) {
+				*eol = 0;
+				if (eol > text && eol[-1] == '\r') eol[-1] = 0;
+			}
+		}
+		n++;
+		if (eol == NULL) break;
+		text = eol + 1;
+	}
+	return n;
+}
+
+// Run one pre-split line of a batch file
+// Parameters:
+// - line: The line to run
+// - number: Line number, for verbose output
+// - buffer: Storage for the line to be executed from
+// - size: Size of buffer (in bytes)
+// - verbose: Echo the line and how long it took to run
+// Returns:
+// - MOS error code
+//
+static int exec_runLine(t_mosExecLine *line, int number, char *buffer, uint24_t size, bool verbose)
+{
+	uint32_t start = 0;
+	uint32_t elapsed;
+	int fr;
+
+	// Commands tokenise their arguments in place, so run from a copy
+	if (line->text != buffer) {
+		buffer[0] = 0;
+		strbuf_append(buffer, size, line->text, size);
+	}
+
+	if (verbose) {
+		kprintf("%d: %s\r\n", number, buffer);
+		start = clock;
+	}
+	fr = mos_execCached(buffer, true, &line->cmd);
+	if (verbose) {
+		elapsed = clock - start;
+		kprintf("%d: %d.%02ds\r\n", number, (int)(elapsed / 100), (int)(elapsed % 100));
+	}
+	return fr;
+}
+
 // Load and run a batch file of MOS commands.
+// The file is read into a heap buffer, a whole file or MOS_execChunkSize
+// bytes at a time, and split into lines before any of them are run.
+// If the heap is too full for that, it falls back to reading a line at a time
 // Parameters:
 // - filename: The batch file to execute
 // - buffer: Storage for each line to be loaded into and executed from (recommend 256 bytes)
 // - size: Size of buffer (in bytes)
+// - verbose: Echo each line and how long it took to run
 // Returns:
 // - FatFS return code (of the last command)
 //
-uint24_t mos_EXEC(char *filename, char *buffer, uint24_t size)
+uint24_t mos_EXEC(char *filename, char *buffer, uint24_t size, bool verbose)
 {
 	FRESULT fr;
 	FIL fil;
+	t_mosExecLine *lines;
+	t_mosExecLine fallback;
+	char *script;
+	char *end;
+	char held;
+	UINT len, br;
+	UINT keep = 0;
+	int count, i;
 	int line = 0;
 
 	fr = f_open(&fil, filename, FA_READ);
-	if (fr == FR_OK) {
+	if (fr != FR_OK) {
+		return fr;
+	}
+
+	len = (UINT)MIN(f_size(&fil) + 1, MOS_execChunkSize);
+	script = umm_malloc(len);
+
+	if (script == NULL) {
+		// Not enough heap, so read and run a line at a time
 		while (!f_eof(&fil)) {
 			line++;
-			f_gets(buffer, size, &fil);
-			fr = mos_exec(buffer, true);
+			fallback.text = f_gets(buffer, size, &fil);
+			fallback.cmd = MOS_CMD_UNRESOLVED;
+			if (fallback.text == NULL) break;
+			fr = exec_runLine(&fallback, line, buffer, size, verbose);
+			if (fr != FR_OK) {
+				kprintf("\r\nError executing %s at line %d\r\n", filename, line);
+				break;
+			}
+		}
+		f_close(&fil);
+		return fr;
+	}
+
+	while (fr == FR_OK) {
+		fr = f_read(&fil, script + keep, len - 1 - keep, &br);
+		if (fr != FR_OK) break;
+		keep += br;
+		if (keep == 0) break;
+		script[keep] = 0;
+
+		// Hold a partial last line back for the next chunk. A line longer
+		// than the whole chunk is split, as f_gets would do
+		end = script + keep;
+		if (!f_eof(&fil)) {
+			char *eol = strrchr(script, '\n');
+			if (eol) end = eol + 1;
+		}
+		held = *end;
+		*end = 0;
+
+		count = exec_splitLines(script, NULL);
+		lines = umm_malloc(count * sizeof(t_mosExecLine));
+		if (lines == NULL) {
+			fr = (FRESULT)MOS_OUT_OF_MEMORY;
+			break;
+		}
+		exec_splitLines(script, lines);
+
+		for (i = 0; i < count; i++) {
+			line++;
+			fr = exec_runLine(&lines[i], line, buffer, size, verbose);
 			if (fr != FR_OK) {
 				kprintf("\r\nError executing %s at line %d\r\n", filename, line);
 				break;
 			}
 		}
+		umm_free(lines);
+
+		*end = held;
+		keep = script + keep - end;
+		memmove(script, end, keep);
 	}
+	umm_free(script);
 	f_close(&fil);
 	return fr;
 }
 
+// Grow the file handle table by MOS_openFilesGrowBy handles
+// Returns:
+// - false if the table is at MOS_maxOpenFiles already, or out of memory
+//
+static bool mos_growFileTable(void)
+{
+	uint8_t count = MIN(mosFileObjects_count + MOS_openFilesGrowBy, MOS_maxOpenFiles);
+	FIL **table;
+
+	if (count <= mosFileObjects_count) {
+		return false;
+	}
+	table = umm_realloc(mosFileObjects, count * sizeof(FIL *));
+	if (!table) {
+		return false;
+	}
+	memset(table + mosFileObjects_count, 0, (count - mosFileObjects_count) * sizeof(FIL *));
+	mosFileObjects = table;
+	mosFileObjects_count = count;
+	return true;
+}
+
 // Open a file
 // Parameters:
 // - filename: Path of file to open
@@ -2066,24 +2336,28 @@ uint24_t mos_EXEC(char *filename, char *buffer, uint24_t size)
 uint24_t mos_FOPEN(char *filename, uint8_t mode)
 {
 	FRESULT fr;
+	FIL *f;
 	int i;
 
-	for (i = 0; i < MOS_maxOpenFiles; i++) {
+	for (i = 0; i < mosFileObjects_count; i++) {
 		if (mosFileObjects[i] == NULL) {
-			FIL *f = umm_malloc(sizeof(FIL));
-			if (!f) return MOS_OUT_OF_MEMORY;
-
-			fr = f_open(f, filename, mode);
-			if (fr == FR_OK) {
-				mosFileObjects[i] = f;
-				return i + 1;
-			} else {
-				umm_free(f);
-				return 0;
-			}
+			break;
 		}
 	}
-	return 0;
+	if (i == mosFileObjects_count && !mos_growFileTable()) {
+		return 0;
+	}
+
+	f = pool_alloc(&filPool);
+	if (!f) return MOS_OUT_OF_MEMORY;
+
+	fr = f_open(f, filename, mode);
+	if (fr != FR_OK) {
+		pool_free(&filPool, f);
+		return 0;
+	}
+	mosFileObjects[i] = f;
+	return i + 1;
 }
 
 // Close file(s)
@@ -2097,18 +2371,20 @@ uint24_t mos_FCLOSE(uint8_t fh)
 	FRESULT fr;
 	int i;
 
-	if (fh > 0 && fh <= MOS_maxOpenFiles) {
+	if (fh > 0 && fh <= mosFileObjects_count) {
 		i = fh - 1;
+		aread_cancel(fh);
 		if (mosFileObjects[i]) {
 			fr = f_close(mosFileObjects[i]);
-			umm_free(mosFileObjects[i]);
+			pool_free(&filPool, mosFileObjects[i]);
 			mosFileObjects[i] = NULL;
 		}
 	} else {
-		for (i = 0; i < MOS_maxOpenFiles; i++) {
+		aread_cancel(0);
+		for (i = 0; i < mosFileObjects_count; i++) {
 			if (mosFileObjects[i]) {
 				fr = f_close(mosFileObjects[i]);
-				umm_free(mosFileObjects[i]);
+				pool_free(&filPool, mosFileObjects[i]);
 				mosFileObjects[i] = NULL;
 			}
 		}
@@ -2131,7 +2407,7 @@ uint24_t mos_FGETC(uint8_t fh)
 	uint8_t c;
 
 	fo = (FIL *)mos_GETFIL(fh);
-	if (fo > 0) {
+	if (fo > 0 && !aread_busy(fh)) {
 		fr = f_read(fo, &c, 1, &br);
 		if (fr == FR_OK) {
 			return	((uint24_t)c) | ((uint24_t)fat_EOF(fo) << 8);
@@ -2149,7 +2425,7 @@ void mos_FPUTC(uint8_t fh, char c)
 {
 	FIL *fo = (FIL *)mos_GETFIL(fh);
 
-	if (fo > 0) {
+	if (fo > 0 && !aread_busy(fh)) {
 		f_putc(c, fo);
 	}
 }
@@ -2168,7 +2444,7 @@ uint24_t mos_FREAD(uint8_t fh, uint24_t buffer, uint24_t btr)
 	FIL *fo = (FIL *)mos_GETFIL(fh);
 	UINT br = 0;
 
-	if (fo > 0) {
+	if (fo > 0 && !aread_busy(fh)) {
 		fr = f_read(fo, (void *)buffer, btr, &br);
 		if (fr == FR_OK) {
 			return br;
@@ -2177,6 +2453,65 @@ uint24_t mos_FREAD(uint8_t fh, uint24_t buffer, uint24_t btr)
 	return 0;
 }
 
+// Read a batch of blocks of data from a file
+// The requests are served in order of offset, not the order given, so that
+// FatFS walks forwards through the file and reloads as few sectors as possible.
+// The file pointer is left after the last block read
+// Parameters:
+// - fh: File handle
+// - reqs: Array of read requests. The count field of each is filled in
+// - count: Number of requests
+// Returns:
+// - FRESULT of the first request that failed, or FR_OK (FR_LOCKED if asynchronous reads are queued on the file)
+//
+uint8_t mos_FREADV(uint8_t fh, t_mosReadVec *reqs, uint24_t count)
+{
+	FRESULT fr = FR_OK;
+	FIL *fo = (FIL *)mos_GETFIL(fh);
+	t_mosReadVec **order;
+	t_mosReadVec *r;
+	UINT br;
+	uint24_t i, j;
+
+	if (fo == 0) {
+		return FR_INVALID_OBJECT;
+	}
+	if (aread_busy(fh)) {
+		return FR_LOCKED;
+	}
+	if (count == 0) {
+		return FR_OK;
+	}
+	for (i = 0; i < count; i++) {
+		reqs[i].count = 0;
+	}
+
+	// Insertion sort of pointers to the requests, by offset. If there is
+	// no heap for it, the requests are served in the order given
+	order = umm_malloc(count * sizeof(t_mosReadVec *));
+	if (order) {
+		for (i = 0; i < count; i++) {
+			r = &reqs[i];
+			for (j = i; j > 0 && order[j - 1]->offset > r->offset; j--) {
+				order[j] = order[j - 1];
+			}
+			order[j] = r;
+		}
+	}
+
+	for (i = 0; i < count && fr == FR_OK; i++) {
+		r = order ? order[i] : &reqs[i];
+		fr = f_lseek(fo, r->offset);
+		if (fr == FR_OK) {
+			fr = f_read(fo, (void *)r->buffer, r->length, &br);
+			r->count = br;
+		}
+	}
+
+	if (order) umm_free(order);
+	return fr;
+}
+
 // Write a block of data from a buffer
 // Parameters:
 // - fh: File handle
@@ -2191,7 +2526,7 @@ uint24_t mos_FWRITE(uint8_t fh, uint24_t buffer, uint24_t btw)
 	FIL *fo = (FIL *)mos_GETFIL(fh);
 	UINT bw = 0;
 
-	if (fo > 0) {
+	if (fo > 0 && !aread_busy(fh)) {
 		fr = f_write(fo, (const void *)buffer, btw, &bw);
 		if (fr == FR_OK) {
 			return bw;
@@ -2204,13 +2539,16 @@ uint24_t mos_FWRITE(uint8_t fh, uint24_t buffer, uint24_t btw)
 // Parameters:
 // - offset: Position of the pointer relative to the start of the file
 // Returns:
-// - FRESULT
+// - FRESULT (FR_LOCKED if asynchronous reads are queued on the file)
 //
 uint8_t mos_FLSEEK(uint8_t fh, uint32_t offset)
 {
 	FIL *fo = (FIL *)mos_GETFIL(fh);
 
 	if (fo > 0) {
+		if (aread_busy(fh)) {
+			return FR_LOCKED;
+		}
 		return f_lseek(fo, offset);
 	}
 	return FR_INVALID_OBJECT;
@@ -2342,7 +2680,7 @@ uint24_t mos_SETINTVECTOR(uint8_t vector, uint24_t address)
 //
 uint24_t mos_GETFIL(uint8_t fh)
 {
-	if (fh > 0 && fh <= MOS_maxOpenFiles) {
+	if (fh > 0 && fh <= mosFileObjects_count) {
 		return (uint24_t)mosFileObjects[fh - 1];
 	}
 	return 0;
@@ -2377,10 +2715,34 @@ int mos_mount(void)
 	return ret;
 }
 
-extern void hxload_vdp(void);
-
-int mos_cmdSIDELOAD(char *p)
+// SIDELOAD [-b | <filename>]
+// Parameters:
+// - ptr: Pointer to the argument string in the line edit buffer
+// Returns:
+// - MOS error code
+//
+int mos_cmdSIDELOAD(char *ptr)
 {
+	char *option;
+
+	if (mos_parseString(NULL, &option)) {
+		t_sideloadStats stats;
+		uint8_t fr;
+
+		kprintf("Waiting for binary sideload...\r\n");
+		fr = sideload_binary(strcasecmp(option, "-b") == 0 ? NULL : option, &stats);
+		if (fr == SIDELOAD_STOPPED) {
+			kprintf("Sender stopped\r\n");
+		} else if (fr != FR_OK) {
+			return fr;
+		}
+		kprintf("%u bytes in %u blocks, %u resent\r\n", stats.bytes, stats.blocks, stats.retries);
+		if (stats.time) {
+			kprintf("%u.%02us, %u KB/s\r\n", (int)(stats.time / 100), (int)(stats.time % 100),
+				(int)((uint32_t)stats.bytes * 100 / 1024 / stats.time));
+		}
+		return 0;
+	}
 	kprintf("Waiting for VDP data...\r\n");
 	hxload_vdp();
 	kprintf("Done\r\n");
@@ -2429,6 +2791,33 @@ int mos_cmdFBMODE(char *p)
 	}
 }
 
+// Move the keyboard buffer to a new ring. Any events waiting in it are lost
+// Parameters:
+// - len: Entries in the new ring, which holds one fewer events, or 0 for the built in one
+// Returns:
+// - MOS error code
+//
+uint8_t mos_KBUFSIZE(uint8_t len)
+{
+	struct keyboard_event_ex_t *buf = NULL;
+	void *old;
+
+	if (len == 1) {
+		return MOS_INVALID_PARAMETER;
+	}
+	if (len > 0) {
+		buf = umm_malloc(len * sizeof(struct keyboard_event_ex_t));
+		if (buf == NULL) {
+			return MOS_OUT_OF_MEMORY;
+		}
+	}
+	old = kbuf_set_buffer(buf, len);
+	if (old) {
+		umm_free(old);
+	}
+	return 0;
+}
+
 static void *fb_scanline_offsets = NULL;
 
 uint24_t mos_FBMODE(int req_mode)
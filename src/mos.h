@@ -19,6 +19,14 @@ typedef struct {
 	char *help;
 } t_mosCommand;
 
+// One read request for mos_FREADV (13 bytes)
+typedef struct {
+	uint32_t offset; // Offset from the start of the file to read from
+	uint24_t length; // Number of bytes to read
+	uint24_t buffer; // Address to read the data into
+	uint24_t count;	 // Set to the number of bytes actually read
+} t_mosReadVec;
+
 /**
  * MOS-specific return codes
  * These extend the FatFS return codes FRESULT
@@ -89,8 +97,9 @@ uint24_t mos_REN(char *srcPath, char *dstPath, bool verbose);
 uint24_t mos_COPY_API(char *srcPath, char *dstPath);
 uint24_t mos_COPY(char *srcPath, char *dstPath, bool verbose);
 uint24_t mos_MKDIR(char *filename);
-uint24_t mos_EXEC(char *filename, char *buffer, uint24_t size);
+uint24_t mos_EXEC(char *filename, char *buffer, uint24_t size, bool verbose);
 uint24_t mos_FBMODE(int req_mode);
+uint8_t mos_KBUFSIZE(uint8_t len);
 
 uint24_t mos_FOPEN(char *filename, uint8_t mode);
 uint24_t mos_FCLOSE(uint8_t fh);
@@ -100,6 +109,7 @@ uint24_t mos_FREAD(uint8_t fh, uint24_t buffer, uint24_t btr);
 uint24_t mos_FWRITE(uint8_t fh, uint24_t buffer, uint24_t btw);
 uint8_t mos_FLSEEK(uint8_t fh, uint32_t offset);
 uint8_t mos_FEOF(uint8_t fh);
+uint8_t mos_FREADV(uint8_t fh, t_mosReadVec *reqs, uint24_t count);
 
 void mos_GETERROR(uint8_t errno, uint24_t address, uint24_t size);
 uint24_t mos_OSCLI(char *cmd);
@@ -129,7 +139,7 @@ uint8_t fat_EOF(FIL *fp);
 #define HELP_DELETE_ARGS "[-f] <filename>"
 
 #define HELP_EXEC "Run a batch file containing MOS commands\r\n"
-#define HELP_EXEC_ARGS "<filename>"
+#define HELP_EXEC_ARGS "[-v] <filename>"
 
 #define HELP_JMP "Jump to the specified address in memory\r\n"
 #define HELP_JMP_ARGS "<addr>"
@@ -161,6 +171,13 @@ uint8_t fat_EOF(FIL *fp);
 		 "default to &40000.\r\n"
 #define HELP_RUN_ARGS "[<addr>]"
 
+#define HELP_SIDELOAD "Receive a program from the VDP as hex records,\r\n" \
+		      "or with -b as checksummed binary blocks.\r\n"  \
+		      "Given a filename, the blocks are written to\r\n" \
+		      "a new file on the SD card instead, using\r\n" \
+		      "RAM from &40000\r\n"
+#define HELP_SIDELOAD_ARGS "[-b | <filename>]"
+
 #define HELP_SAVE "Save a block of memory to the SD card\r\n"
 #define HELP_SAVE_ARGS "<filename> <addr> <size>"
 
@@ -189,7 +206,12 @@ uint8_t fat_EOF(FIL *fp);
 		 "Serial Console\r\n"                          \
 		 "SET CONSOLE n: Serial console\r\n"           \
 		 "    0: Console off (default)\r\n"            \
-		 "    1: Console on\r\n"
+		 "    1: Console on\r\n"                       \
+		 "\r\n"                                        \
+		 "Keyboard Buffer\r\n"                         \
+		 "SET KEYBUF n: Keyboard events to buffer\r\n" \
+		 "    0: The built in buffer of 31\r\n"        \
+		 "    1-254: Allocated from the MOS heap\r\n"
 #define HELP_SET_ARGS "<option> <value>"
 
 #define HELP_TIME "Set and read the ESP32 real-time clock\r\n"
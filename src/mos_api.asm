@@ -24,6 +24,14 @@
 ; 03/08/2023:	Added mos_api_setkbvector
 ; 10/08/2023:	Added mos_api_getkbmap
 ; 10/11/2023:	Added mos_api_i2c_close, mos_api_i2c_open, mos_api_i2c_read, mos_api_i2c_write
+; 16/10/2026:	mos_api_fgetc and mos_api_fputc serve bytes straight from the FatFS sector window
+;		Added mos_api_freadv, mos_api_aread_submit, mos_api_aread_poll and mos_api_aread_wait
+;		Added mos_api_setvdpbuffer
+;		Added mos_api_ugetc_nb, mos_api_uputc_nb and mos_api_ustats
+;		Added mos_api_uread and mos_api_uwrite
+;		Added mos_api_kbufstats, mos_api_kbufsize and mos_api_pollkeyboardevent_ex
+;		mos_api_getkey sleeps in idle_halt while waiting
+;		mos_api_getkey does a slice of any queued asynchronous reads while waiting
 
 
 			.ASSUME	ADL = 1
@@ -36,7 +44,10 @@
 			XREF	SET_AHL24
 			XREF	GET_AHL24
 			XREF	SET_ADE24
+			XREF	idle_halt
 			XREF	kbuf_remove
+			XREF	kbuf_remove_ex
+			XREF	_kbuf_stats
 			XREF	_mos_OSCLI		; In mos.c
 			XREF	_mos_EDITLINE
 			XREF	_mos_LOAD
@@ -60,21 +71,40 @@
 			XREF	_mos_FREAD
 			XREF	_mos_FWRITE
 			XREF	_mos_FLSEEK
+			XREF	_mos_FREADV
+			XREF	_aread_submit		; In async_read.c
+			XREF	_aread_poll
+			XREF	_aread_wait
+			XREF	_aread_service
+			XREF	_aread_queued
+			XREF	_vdp_bulk_ptr
+			XREF	_vdp_bulk_size
 			XREF	_mos_I2C_OPEN
 			XREF	_mos_I2C_CLOSE
 			XREF	_mos_I2C_WRITE
 			XREF	_mos_I2C_READ
 			XREF	_mos_FBMODE
+			XREF	_mos_KBUFSIZE
 			XREF	_console_enable_fb
 			XREF	_console_enable_vdp
 			
 			XREF	_fat_EOF		; In mos.c
+			XREF	_mosFileObjects
+			XREF	_mosFileObjects_count
+			XREF	_mos_fsWin
+			XREF	_mos_fsWinSect
+			XREF	_mos_fsWFlag
 
 			XREF	_open_UART1		; In uart.c
 			XREF	_close_UART1
 
 			XREF	UART1_serial_GETCH	; In serial.asm
 			XREF	UART1_serial_PUTCH 
+			XREF	UART1_serial_RX
+			XREF	UART1_serial_TX
+			XREF	_uart1Stats		; In uart.c
+			XREF	_read_UART1
+			XREF	_write_UART1
 			
 			XREF	_keyascii		; In globals.asm
 			XREF	_keycount
@@ -215,20 +245,20 @@ mos_api_block1_start:	DW	mos_api_getkey		; 0x00
 			DW  mos_api_pollkeyboardevent ; 0x62
 			DW  mos_api_set_fbmode ; 0x63
 			DW  mos_api_set_stdout ; 0x64
-			DW  mos_api_not_implemented ; 0x65
-			DW  mos_api_not_implemented ; 0x66
-			DW  mos_api_not_implemented ; 0x67
-			DW  mos_api_not_implemented ; 0x68
-			DW  mos_api_not_implemented ; 0x69
-			DW  mos_api_not_implemented ; 0x6a
-			DW  mos_api_not_implemented ; 0x6b
-			DW  mos_api_not_implemented ; 0x6c
-			DW  mos_api_not_implemented ; 0x6d
-			DW  mos_api_not_implemented ; 0x6e
-			DW  mos_api_not_implemented ; 0x6f
-
-			DW  mos_api_not_implemented ; 0x70
-			DW  mos_api_not_implemented ; 0x71
+			DW  mos_api_freadv ; 0x65
+			DW  mos_api_aread_submit ; 0x66
+			DW  mos_api_aread_poll ; 0x67
+			DW  mos_api_aread_wait ; 0x68
+			DW  mos_api_setvdpbuffer ; 0x69
+			DW  mos_api_ugetc_nb ; 0x6a
+			DW  mos_api_uputc_nb ; 0x6b
+			DW  mos_api_ustats ; 0x6c
+			DW  mos_api_uread ; 0x6d
+			DW  mos_api_uwrite ; 0x6e
+			DW  mos_api_kbufstats ; 0x6f
+
+			DW  mos_api_kbufsize ; 0x70
+			DW  mos_api_pollkeyboardevent_ex ; 0x71
 			DW  mos_api_not_implemented ; 0x72
 			DW  mos_api_not_implemented ; 0x73
 			DW  mos_api_not_implemented ; 0x74
@@ -302,15 +332,41 @@ mos_api_not_implemented:
 ; Returns:
 ;  A: ASCII code of key pressed, or 0 if no key pressed
 ;
-mos_api_getkey:		PUSH	HL
+mos_api_getkey:		PUSH	BC
+			PUSH	HL
 			LD	HL, _keycount	
-mos_api_getkey_1:	LD	A, (HL)			; Wait for a key to be pressed
-1:			CP	(HL)
-			JR	Z, 1b 
-			LD	A, (_keydown)		; Check if key is down
+mos_api_getkey_1:	LD	B, (HL)			; Wait for a key to be pressed
+1:			PUSH	BC
+			PUSH	DE
+			PUSH	HL
+			CALL	_aread_service		; Do a slice of any queued file reads
+			POP	HL
+			POP	DE
+			POP	BC
+			LD	C, A			; C: Nonzero if there was one
+			LD	A, I			; P/V: Whether interrupts are enabled
+			DI
+			PUSH	AF
+			LD	A, B			; Has a key packet arrived?
+			CP	(HL)
+			JR	NZ, 2f
+			POP	AF			; No, so if interrupts are enabled
+			JP	PO, 1b
+			LD	A, C			; and there was no read to do
+			OR	A, A
+			JR	Z, 4f
+			EI				; (if there was, there may be more)
+			JR	1b
+4:			CALL	idle_halt		; then sleep until the next one
+			JR	1b
+2:			POP	AF			; Yes, so re-enable interrupts if they were
+			JP	PO, 3f
+			EI
+3:			LD	A, (_keydown)		; Check if key is down
 			OR	A 
 			JR	Z, mos_api_getkey_1	; No, so loop
 			POP	HL 
+			POP	BC
 			LD	A, (_keyascii)		; Get the key code
 			RET
 			
@@ -598,6 +654,31 @@ mos_api_fclose:		PUSH	BC
 			POP	BC
 			RET
 			
+; The FatFS FFOBJID and FIL structures, field for field as in mos_api.inc,
+; whose .STRUCT syntax the assembler does not take. Only the offsets are used
+;
+			.struct	0
+FFOBJID.fs:		DS	3	; Pointer to the hosting volume of this object
+FFOBJID.id:		DS	2	; Hosting volume mount ID
+FFOBJID.attr:		DS	1	; Object attribute
+FFOBJID.stat:		DS	1	; Object chain status
+FFOBJID.sclust:		DS	4	; Object data start cluster
+FFOBJID.objsize:	DS	4	; Object size
+FFOBJID_SIZE:
+;
+			.struct	0
+FIL.obj:		DS	FFOBJID_SIZE	; Object identifier
+FIL.flag:		DS	1	; File status flags
+FIL.err:		DS	1	; Abort flag (error code)
+FIL.fptr:		DS	4	; File read/write pointer
+FIL.clust:		DS	4	; Current cluster of fptr
+FIL.sect:		DS	4	; Sector number appearing in buf[]
+FIL.dir_sect:		DS	4	; Sector number containing the directory entry
+FIL.dir_ptr:		DS	3	; Pointer to the directory entry in the win[]
+FIL_SIZE:
+;
+			.text
+
 ; Get a character from a file
 ;   C: Filehandle
 ; Returns:
@@ -609,8 +690,23 @@ mos_api_fgetc:		PUSH	BC
 			PUSH	HL
 			PUSH	IX
 			PUSH	IY
-;			
-			LD	DE, 0
+;
+			CALL	fast_file		; Is the byte in the sector window?
+			JR	NZ, mos_api_fgetc_slow
+			BIT	0, (IY + FIL.flag)	; Open with FA_READ?
+			JR	Z, mos_api_fgetc_slow
+			CALL	fast_eof		; Already at the end of the file?
+			JR	Z, mos_api_fgetc_slow
+			LD	C, (HL)			; C: Character read
+			CALL	fast_advance
+			CALL	fast_eof		; F: C = EOF
+			SCF
+			JR	Z, 1f
+			CCF
+1:			LD	A, C
+			JR	mos_api_fgetc_exit
+;
+mos_api_fgetc_slow:	LD	DE, 0
 			LD	E, C
 			PUSH	DE		; byte	  fh
 			CALL	_mos_FGETC	; Read the character
@@ -618,7 +714,7 @@ mos_api_fgetc:		PUSH	BC
 			LD	A, L 		; A: Character read
 			SRL	H 		; F: C = EOF
 ;
-			POP	IY
+mos_api_fgetc_exit:	POP	IY
 			POP	IX
 			POP	HL
 			POP	DE
@@ -635,8 +731,27 @@ mos_api_fputc:		PUSH	AF
 			PUSH	HL
 			PUSH	IX
 			PUSH	IY
-;		
-			LD	DE, 0
+;
+			CALL	fast_file		; Is the byte in the sector window?
+			JR	NZ, mos_api_fputc_slow
+			BIT	1, (IY + FIL.flag)	; Open with FA_WRITE?
+			JR	Z, mos_api_fputc_slow
+			LD	(HL), B			; Write the character
+			LD	HL, (_mos_fsWFlag)	; Mark the window dirty
+			LD	(HL), 1
+			SET	6, (IY + FIL.flag)	; FA_MODIFIED
+			CALL	fast_eof		; Appending?
+			PUSH	AF
+			CALL	fast_advance
+			POP	AF
+			JR	NZ, mos_api_fputc_exit
+			LD	HL, (IY + FIL.fptr)	; Yes, so the file grows with it
+			LD	(IY + FIL.obj + FFOBJID.objsize), HL
+			LD	A, (IY + FIL.fptr + 3)
+			LD	(IY + FIL.obj + FFOBJID.objsize + 3), A
+			JR	mos_api_fputc_exit
+;
+mos_api_fputc_slow:	LD	DE, 0
 			LD	E, B		
 			PUSH	DE		; byte	  char
 			LD	E, C
@@ -645,13 +760,115 @@ mos_api_fputc:		PUSH	AF
 			POP	DE
 			POP	DE
 ;			
-			POP	IY
+mos_api_fputc_exit:	POP	IY
 			POP	IX
 			POP	HL
 			POP	DE
 			POP	BC
 			POP	AF
 			RET
+
+; Find an open file whose next byte can be read or written in place in the
+; FatFS sector window. That is when the file pointer is part way through the
+; file's current sector, and that sector is the one held in the window
+;   C: Filehandle
+; Returns:
+;  IY: Pointer to the FIL
+;  HL: Address of the byte in the sector window
+;   F: Z if so, NZ if the call must go through FatFS
+; Corrupts:
+;   A, DE
+;
+fast_file:		LD	A, (_aread_queued)	; Any asynchronous reads queued?
+			OR	A, A
+			JR	NZ, fast_file_no	; Then mos_FGETC/mos_FPUTC check the handle
+			LD	A, C
+			DEC	A			; Handles start at 1
+			LD	HL, _mosFileObjects_count
+			CP	A, (HL)
+			JR	NC, fast_file_no
+			LD	DE, 0
+			LD	E, A
+			LD	HL, (_mosFileObjects)
+			ADD	HL, DE
+			ADD	HL, DE
+			ADD	HL, DE
+			LD	HL, (HL)		; HL: FIL pointer, or 0 if not open
+			LD	DE, 0
+			OR	A, A
+			SBC	HL, DE
+			JR	Z, fast_file_no
+			PUSH	HL
+			POP	IY
+;
+			LD	A, (IY + FIL.err)	; Aborted by a previous error?
+			OR	A, A
+			JR	NZ, fast_file_no
+			LD	A, (IY + FIL.fptr + 1)	; Is the pointer on a sector boundary?
+			AND	A, 1
+			LD	D, A
+			LD	A, (IY + FIL.fptr + 0)
+			LD	E, A
+			OR	A, D
+			JR	Z, fast_file_no
+;
+			LD	HL, (_mos_fsWinSect)	; Is the file's sector in the window?
+			LD	A, (IY + FIL.sect + 0)
+			CP	A, (HL)
+			JR	NZ, fast_file_no
+			INC	HL
+			LD	A, (IY + FIL.sect + 1)
+			CP	A, (HL)
+			JR	NZ, fast_file_no
+			INC	HL
+			LD	A, (IY + FIL.sect + 2)
+			CP	A, (HL)
+			JR	NZ, fast_file_no
+			INC	HL
+			LD	A, (IY + FIL.sect + 3)
+			CP	A, (HL)
+			JR	NZ, fast_file_no
+;
+			LD	HL, (_mos_fsWin)	; HL: window + (fptr % 512)
+			ADD	HL, DE
+			XOR	A, A
+			RET
+;
+fast_file_no:		OR	A, 1
+			RET
+
+; Check whether a file pointer is at the end of the file
+;  IY: Pointer to the FIL
+; Returns:
+;   F: Z if at the end of the file
+; Corrupts:
+;   A
+;
+fast_eof:		LD	A, (IY + FIL.fptr + 0)
+			CP	A, (IY + FIL.obj + FFOBJID.objsize + 0)
+			RET	NZ
+			LD	A, (IY + FIL.fptr + 1)
+			CP	A, (IY + FIL.obj + FFOBJID.objsize + 1)
+			RET	NZ
+			LD	A, (IY + FIL.fptr + 2)
+			CP	A, (IY + FIL.obj + FFOBJID.objsize + 2)
+			RET	NZ
+			LD	A, (IY + FIL.fptr + 3)
+			CP	A, (IY + FIL.obj + FFOBJID.objsize + 3)
+			RET
+
+; Advance a file pointer by one byte
+;  IY: Pointer to the FIL
+; Corrupts:
+;  DE, HL
+;
+fast_advance:		LD	HL, (IY + FIL.fptr)
+			LD	DE, 1
+			ADD	HL, DE
+			LD	(IY + FIL.fptr), HL
+			RET	NC
+			INC	(IY + FIL.fptr + 3)
+			RET
 			
 ; Check whether we're at the end of the file
 ;   C: Filehandle
@@ -1000,9 +1217,9 @@ mos_api_i2c_read:	PUSH	DE
 ;	+4: Stop bits
 ;	+5: Parity bits
 ;	+6: Flow control (0: None, 1: Hardware)
-;	+7: Enabled interrupts
+;	+7: Enabled interrupts (ignored; UART1 is always interrupt driven)
 ; Returns:
-;   A: Error code (0 = no error)
+;   A: Error code (0 = no error, 0xFF if the rings could not be allocated)
 ;
 mos_api_uopen:		LEA	HL, IX + 0	; HLU: Pointer to struct
 			LD	A, MB 		; If in 64K segment when
@@ -1118,6 +1335,245 @@ mos_api_flseek_p:	CALL	FIX_HLU24	; Fix the HLU to ensure it's a 24-bit pointer
 			RET
 
 
+; Read a batch of blocks of data from a file
+;  A = 0x65
+;   C: Filehandle
+; HLU: Pointer to an array of 13 byte read requests, each:
+;      DWORD offset, UINT24 length, UINT24 buffer, UINT24 count
+;      The count of bytes actually read is filled in by MOS
+;      Buffers are always 24-bit addresses
+; DEU: Number of read requests
+; Returns:
+;   A: FRESULT of the first request that failed, or 0
+;
+mos_api_freadv:		LD	A, MB		; Check if MBASE is 0
+			OR	A, A
+			CALL	NZ, SET_AHL24
+			PUSH	DE		; UINT24 count
+			PUSH	HL		; t_mosReadVec * reqs
+			PUSH	BC		; UINT8 fh
+			CALL	_mos_FREADV
+			LD	A, L		; FRESULT
+			POP	BC
+			POP	HL
+			POP	DE
+			RET
+
+; Queue an asynchronous read from the current file pointer, or from the end
+; of the read last queued on the same file
+; The read is done a slice at a time by mos_api_aread_poll/mos_api_aread_wait,
+; and while MOS waits in mos_api_getkey or for the VDP. Until all the reads on
+; the file are done, calls that use or move its file pointer are refused
+;  A = 0x66
+;   C: Filehandle
+; HLU: Pointer to where to read the data to
+; DEU: Number of bytes to read
+; Returns:
+;   A: Ticket, or 0 if the handle is not open or the queue is full
+;
+mos_api_aread_submit:	LD	A, MB		; Check if MBASE is 0
+			OR	A, A
+			CALL	NZ, SET_AHL24
+			PUSH	DE		; UINT24 length
+			PUSH	HL		; UINT24 buffer
+			PUSH	BC		; UINT8 fh
+			CALL	_aread_submit
+			LD	A, L		; Ticket
+			POP	BC
+			POP	HL
+			POP	DE
+			RET
+
+; Do the next slice of the queued asynchronous reads, and check on one
+; A ticket is freed once it has been reported as done
+;  A = 0x67
+;   C: Ticket
+; Returns:
+;   A: 0xFF if still in progress, otherwise FRESULT of the read
+; DEU: Number of bytes read so far
+;
+mos_api_aread_poll:	PUSH	HL
+			LD	HL, _scratchpad
+			PUSH	HL		; UINT24 * count
+			PUSH	BC		; UINT8 ticket
+			CALL	_aread_poll
+			LD	A, L		; Status
+			POP	BC
+			POP	HL
+			POP	HL
+			LD	DE, (_scratchpad)
+			RET
+
+; Wait for an asynchronous read to finish
+;  A = 0x68
+;   C: Ticket
+; Returns:
+;   A: FRESULT of the read
+; DEU: Number of bytes read
+;
+mos_api_aread_wait:	PUSH	HL
+			LD	HL, _scratchpad
+			PUSH	HL		; UINT24 * count
+			PUSH	BC		; UINT8 ticket
+			CALL	_aread_wait
+			LD	A, L		; FRESULT
+			POP	BC
+			POP	HL
+			POP	HL
+			LD	DE, (_scratchpad)
+			RET
+
+; Set the buffer that VDP packets longer than 16 bytes are received into
+; When one has arrived, bit 7 of sysvar_vpd_pflags is set, and the command
+; and length are in sysvar_vdpBulkCmd and sysvar_vdpBulkLen. Further long
+; packets are discarded until the caller clears the flag
+;  A = 0x69
+; HLU: Pointer to the buffer
+;   C: Size of the buffer (up to 255), or 0 to discard long packets
+; Returns:
+;   A: 0
+;
+mos_api_setvdpbuffer:	LD	A, MB		; Check if MBASE is 0
+			OR	A, A
+			CALL	NZ, SET_AHL24
+			XOR	A		; Stop any new long packets while the pointer changes
+			LD	(_vdp_bulk_size), A
+			LD	(_vdp_bulk_ptr), HL
+			LD	A, C
+			LD	(_vdp_bulk_size), A
+			PUSH	HL
+			LD	HL, _vpd_protocol_flags
+			RES	7, (HL)		; Clear the long packet received flag
+			POP	HL
+			XOR	A
+			RET
+
+; Get a character from UART1, if one has been received
+;  A = 0x6A
+; Returns:
+;   A: Character read
+;   F: C if successful
+;   F: NC if nothing has been received, or the UART is not open
+;
+mos_api_ugetc_nb:	JP	UART1_serial_RX
+
+; Queue a character to send on UART1, if there is room
+;  A = 0x6B
+;   C: Character to write
+; Returns:
+;   F: C if successful
+;   F: NC if the transmit ring is full, or the UART is not open
+;
+mos_api_uputc_nb:	LD	A, C
+			JP	UART1_serial_TX
+
+; Get the UART1 receive statistics
+; These are reset by mos_api_uopen
+;  A = 0x6C
+; Returns:
+; HLU: Pointer to the statistics
+;	+0: Characters lost because the UART1 FIFO overran (24-bit)
+;	+3: Characters lost because the receive ring was full (24-bit)
+;
+mos_api_ustats:		LD	HL, _uart1Stats
+			RET
+
+; Read a block of data from UART1
+;  A = 0x6D
+; HLU: Pointer to where to write the data to
+; DEU: Number of bytes to read
+; BCU: Timeout in milliseconds, or 0 to only read what has already been received
+; Returns:
+; DEU: Number of bytes read
+;
+mos_api_uread:		LD	A, MB		; Check if MBASE is 0
+			OR	A, A
+			CALL	NZ, SET_AHL24
+			PUSH	BC		; UINT24 timeout
+			PUSH	DE		; UINT24 len
+			PUSH	HL		; UINT8 * buf
+			CALL	_read_UART1
+			LD	(_scratchpad), HL
+			POP	HL
+			POP	DE
+			POP	BC
+			LD	DE, (_scratchpad)
+			RET
+
+; Write a block of data to UART1
+;  A = 0x6E
+; HLU: Pointer to the data
+; DEU: Number of bytes to write
+; BCU: Timeout in milliseconds, or 0 to only write what fits in the transmit ring
+; Returns:
+; DEU: Number of bytes written
+;
+mos_api_uwrite:		LD	A, MB		; Check if MBASE is 0
+			OR	A, A
+			CALL	NZ, SET_AHL24
+			PUSH	BC		; UINT24 timeout
+			PUSH	DE		; UINT24 len
+			PUSH	HL		; UINT8 * buf
+			CALL	_write_UART1
+			LD	(_scratchpad), HL
+			POP	HL
+			POP	DE
+			POP	BC
+			LD	DE, (_scratchpad)
+			RET
+
+; Get the keyboard buffer statistics
+;  A = 0x6F
+; Returns:
+; HLU: Pointer to the statistics
+;	+0: Events lost because the buffer was full (24-bit)
+;	+3: Entries in the buffer, which holds one fewer events
+;	+4: Most events that have waited in the buffer at once
+;
+mos_api_kbufstats:	LD	HL, _kbuf_stats
+			RET
+
+; Resize the keyboard buffer. Any events waiting in it are lost
+;  A = 0x70
+;   C: Entries in the buffer (2 to 255), allocated from the MOS heap, or 0 for the built in one
+; Returns:
+;   A: Status code
+;
+mos_api_kbufsize:	PUSH	BC		; UINT8 len
+			CALL	_mos_KBUFSIZE
+			POP	BC
+			RET
+
+; Fetch the next keyboard event, with the time it arrived
+;  A = 0x71
+;   DEU - Address of 8-byte buffer to write the event to
+; Return:
+;   A=0 IF no event
+;   A=1 IF event
+;   (DE+0) - Event ASCII value
+;   (DE+1) - Event keymods (alt, ctrl, etc)
+;   (DE+2) - Event FabGL vkey
+;   (DE+3) - 0=Key Up, 1=Key Down
+;   (DE+4) - sysvar_time when the event arrived (32-bit)
+mos_api_pollkeyboardevent_ex:
+			PUSH	BC
+			PUSH	DE
+			PUSH	HL
+
+			LD	A, MB		; Check if MBASE is 0
+			OR	A, A
+			JR	Z, 1f		; If it is, we can assume DE is 24 bit
+			CALL	SET_ADE24
+		1:
+			CALL	kbuf_remove_ex
+			POP	HL
+			POP	DE
+			POP	BC
+			LD	A,1
+			RET	NZ
+			XOR	A
+			RET
+
 ; Inject a byte into the uart0 receiver. This
 ; simulates bytes being received from the VDP
 ; Params:
@@ -12,6 +12,8 @@
  * 21/03/2023:		Improved backspace, and editing of long lines, after scroll, at bottom of screen
  * 22/03/2023:		Added a single-entry command line history
  * 31/03/2023:		Added timeout for VDP protocol
+ * 16/10/2026:		Track the cursor column locally rather than asking the VDP on every cursor move
+ * 16/10/2026:		Redraw the line tail in one write and place the cursor with VDU 31
  */
 
 #include "mos_editor.h"
@@ -43,19 +45,91 @@ static char *cmd_history[cmd_historyDepth];
 
 char *hotkey_strings[12] = {};
 
+// The cursor position, tracked from the characters the editor sends so that
+// moving the cursor doesn't need a round trip to the VDP; editCursorX is -1
+// if the position is not known
+//
+static int editCursorX = -1;
+static int editCursorY;
+
+// Make sure the cursor position is known, asking the VDP only if it isn't
+//
+static void editSyncCursor()
+{
+	if (editCursorX < 0) {
+		active_console->get_cursor_pos();
+		editCursorX = cursorX;
+		editCursorY = cursorY;
+	}
+}
+
+// Output a character, keeping track of the cursor position
+// Anything that might wrap or scroll the line, or that isn't understood,
+// makes the position unknown, so it is asked for again when next needed
+//
+static void editPutch(uint8_t c)
+{
+	putch(c);
+	if (editCursorX < 0) {
+		return;
+	}
+	if (c >= 0x20 && c != 0x7F) {
+		editCursorX = (editCursorX < scrcols - 1) ? editCursorX + 1 : -1;
+		return;
+	}
+	switch (c) {
+	case 0x07:		// Bell
+		break;
+	case 0x0A:		// Cursor down
+		if (editCursorY < scrrows - 1) {
+			editCursorY++;
+		} else {
+			editCursorX = -1;
+		}
+		break;
+	case 0x0B:		// Cursor up
+		if (editCursorY > 0) {
+			editCursorY--;
+		} else {
+			editCursorX = -1;
+		}
+		break;
+	case 0x08:		// Cursor left
+		editCursorX = (editCursorX > 0) ? editCursorX - 1 : -1;
+		break;
+	case 0x09:		// Cursor right
+		editCursorX = (editCursorX < scrcols - 1) ? editCursorX + 1 : -1;
+		break;
+	case 0x0D:		// Carriage return
+		editCursorX = 0;
+		break;
+	default:
+		editCursorX = -1;
+		break;
+	}
+}
+
+// Output up to len characters of a string, keeping track of the cursor position
+//
+static void editPrint(const char *s, int len)
+{
+	while (len-- > 0 && *s) {
+		editPutch(*s++);
+	}
+}
+
 // Move cursor left
 //
 static void doLeftCursor()
 {
-	active_console->get_cursor_pos();
-	if (cursorX > 0) {
-		putch(0x08);
+	editSyncCursor();
+	if (editCursorX > 0) {
+		editPutch(0x08);
 	} else {
-		while (cursorX < (scrcols - 1)) {
-			putch(0x09);
-			cursorX++;
+		while (editCursorX < (scrcols - 1)) {
+			editPutch(0x09);
 		}
-		putch(0x0B);
+		editPutch(0x0B);
 	}
 }
 
@@ -63,16 +137,81 @@ static void doLeftCursor()
 //
 static void doRightCursor()
 {
-	active_console->get_cursor_pos();
-	if (cursorX < (scrcols - 1)) {
-		putch(0x09);
+	editSyncCursor();
+	if (editCursorX < (scrcols - 1)) {
+		editPutch(0x09);
 	} else {
-		while (cursorX > 0) {
-			putch(0x08);
-			cursorX--;
+		while (editCursorX > 0) {
+			editPutch(0x08);
 		}
-		putch(0x0A);
+		editPutch(0x0A);
+	}
+}
+
+// Move the cursor to an absolute position with VDU 31
+//
+static void editGotoXY(int x, int y)
+{
+	putch(31);
+	putch(x);
+	putch(y);
+	editCursorX = x;
+	editCursorY = y;
+}
+
+// Move the cursor by a number of characters along the line
+//
+static void editMoveCursor(int delta)
+{
+	int pos;
+
+	if (delta == 0) {
+		return;
+	}
+	editSyncCursor();
+	pos = editCursorY * scrcols + editCursorX + delta;
+	if (pos >= 0 && pos < scrrows * scrcols) {
+		editGotoXY(pos % scrcols, pos / scrcols);
+		return;
+	}
+	for (; delta < 0; delta++) {
+		doLeftCursor();
+	}
+	for (; delta > 0; delta--) {
+		doRightCursor();
+	}
+}
+
+// Redraw part of the line from the cursor, then leave the cursor a number of
+// characters on from where it started
+// Parameters:
+// - s: The characters to draw
+// - count: The number of characters to draw
+// - blank: Draw a space after them, to rub out a deleted character
+// - advance: Where to leave the cursor, relative to where it started
+//
+static void editRedraw(const char *s, int count, bool blank, int advance)
+{
+	const int printed = count + (blank ? 1 : 0);
+	int pos;
+
+	editSyncCursor();
+	pos = editCursorY * scrcols + editCursorX;
+	if ((pos + printed) / scrcols >= scrrows) {
+		// The screen may scroll, so the start position won't be right afterwards
+		editPrint(s, count);
+		if (blank) {
+			editPutch(' ');
+		}
+		editMoveCursor(advance - printed);
+		return;
 	}
+	putblock(s, count);
+	if (blank) {
+		putch(' ');
+	}
+	pos += advance;
+	editGotoXY(pos % scrcols, pos / scrcols);
 }
 
 // Insert a character in the input string
@@ -81,22 +220,16 @@ static void doRightCursor()
 //
 static bool insertCharacter(char *buffer, int buffer_capacity, char c, int insertPos)
 {
-	int i;
-	int count = 0;
 	const int len = strnlen(buffer, buffer_capacity);
 
 	if (len < buffer_capacity - 1) {
-		putch(c);
-		for (i = len; i >= insertPos; i--) {
-			buffer[i + 1] = buffer[i];
-		}
+		memmove(&buffer[insertPos + 1], &buffer[insertPos], len - insertPos + 1);
 		buffer[insertPos] = c;
 
-		for (i = insertPos + 1; i <= len; i++, count++) {
-			putch(buffer[i]);
-		}
-		for (i = 0; i < count; i++) {
-			doLeftCursor();
+		if (insertPos == len) {
+			editPutch(c);
+		} else {
+			editRedraw(&buffer[insertPos], len + 1 - insertPos, false, 1);
 		}
 		return 1;
 	}
@@ -113,18 +246,10 @@ static bool insertCharacter(char *buffer, int buffer_capacity, char c, int inser
 //
 static bool deleteCharacter(char *buffer, int insertPos, int len)
 {
-	int i;
-	int count = 0;
 	if (insertPos > 0) {
 		doLeftCursor();
-		for (i = insertPos - 1; i < len; i++, count++) {
-			uint8_t b = buffer[i + 1];
-			buffer[i] = b;
-			putch(b ? b : ' ');
-		}
-		for (i = 0; i < count; i++) {
-			doLeftCursor();
-		}
+		memmove(&buffer[insertPos - 1], &buffer[insertPos], len - insertPos + 1);
+		editRedraw(&buffer[insertPos - 1], len - insertPos, true, 0);
 		return 1;
 	}
 	return 0;
@@ -152,20 +277,17 @@ static uint8_t deleteWord(char *buffer, int insertPos, int len)
 //
 static int gotoEditLineStart(int insertPos)
 {
-	while (insertPos > 0) {
-		doLeftCursor();
-		insertPos--;
-	}
-	return insertPos;
+	editMoveCursor(-insertPos);
+	return 0;
 }
 
 // handle END
 //
 static int gotoEditLineEnd(int insertPos, int len)
 {
-	while (insertPos < len) {
-		doRightCursor();
-		insertPos++;
+	if (insertPos < len) {
+		editMoveCursor(len - insertPos);
+		insertPos = len;
 	}
 	return insertPos;
 }
@@ -179,7 +301,7 @@ static void removeEditLine(char *buffer, int insertPos, int len)
 	// set buffer to be spaces up to len
 	memset(buffer, ' ', len);
 	// print the buffer to erase old line from screen
-	kprintf("%s", buffer);
+	editPrint(buffer, len);
 	// clear the buffer
 	buffer[0] = 0;
 	gotoEditLineStart(len);
@@ -198,7 +320,7 @@ static bool handleHotkey(uint8_t fkey, char *buffer, int bufferLength, int inser
 			removeEditLine(buffer, insertPos, len);
 			buffer[0] = 0;
 			strbuf_append(buffer, bufferLength, hotkey_strings[fkey], bufferLength);
-			kprintf("%s", buffer);
+			editPrint(buffer, bufferLength);
 		} else {
 			uint8_t prefixLength = wildcardPos - hotkey_strings[fkey];
 			uint8_t replacementLength = strlen(buffer);
@@ -227,7 +349,7 @@ static bool handleHotkey(uint8_t fkey, char *buffer, int bufferLength, int inser
 			removeEditLine(buffer, insertPos, len);
 			buffer[0] = 0;
 			strbuf_append(buffer, bufferLength, result, result_capacity);
-			kprintf("%s", buffer);
+			editPrint(buffer, bufferLength);
 
 			umm_free(result);
 		}
@@ -486,10 +608,8 @@ static void do_tab_complete(char *buffer, int buffer_len, int *out_InsertPos)
 		putch('\r');
 		mos_print_prompt();
 		kprintf("%s", buffer);
-		uint8_t insert_pos_adjust = strlen(buffer) - (*out_InsertPos);
-		while (insert_pos_adjust--) {
-			doLeftCursor();
-		}
+		editCursorX = -1;  // Don't know where the prompt and candidates left it
+		editMoveCursor((*out_InsertPos) - (int)strlen(buffer));
 	}
 
 	if (tab_ctx.num_matches > 1 && num_chars_added == 0) {
@@ -502,17 +622,14 @@ static void do_tab_complete(char *buffer, int buffer_len, int *out_InsertPos)
 		}
 		const bool append_at_eol = (*out_InsertPos) == (int)strlen(buffer);
 		int chars_inserted = strbuf_insert(buffer, buffer_len, tab_ctx.expansion, *out_InsertPos);
-		kprintf("%.*s", chars_inserted, tab_ctx.expansion);
+		editPrint(tab_ctx.expansion, chars_inserted);
 
 		*out_InsertPos = (*out_InsertPos) + chars_inserted;
 		if (!append_at_eol) {
 			// also need to redraw part of cmd after insert pos
-			int len_tail = strlen(&buffer[*out_InsertPos]);
-			kprintf("%.*s", len_tail, &buffer[*out_InsertPos]);
 			// then move back to insert pos
-			while (len_tail--) {
-				doLeftCursor();
-			}
+			int len_tail = strlen(&buffer[*out_InsertPos]);
+			editRedraw(&buffer[*out_InsertPos], len_tail, false, 0);
 		}
 	}
 
@@ -546,6 +663,7 @@ uint24_t mos_EDITLINE(char *buffer, int bufferLength, uint8_t flags)
 	history_no = history_size;		// Ensure our current "history" is the end of the list
 
 	active_console->get_mode_information(); // Get the current screen dimensions
+	editCursorX = -1;			// Ask for the cursor position when it is first needed
 
 	if (clear) {				// Clear the buffer as required
 		// memset(buffer, 0, bufferLength);
@@ -562,6 +680,7 @@ uint24_t mos_EDITLINE(char *buffer, int bufferLength, uint8_t flags)
 		struct keyboard_event_t ev;
 		uint8_t historyAction = 0;
 		len = strlen(buffer);
+		kflush(); // Nothing should be left in the kprintf buffer while waiting for a key
 		kbuf_wait_keydown(&ev);
 		keya = ev.ascii;
 
@@ -702,7 +821,7 @@ uint24_t mos_EDITLINE(char *buffer, int bufferLength, uint8_t flags)
 			}
 
 			if (lineChanged) {
-				kprintf("%s", buffer);	    // Output the buffer
+				editPrint(buffer, bufferLength);	    // Output the buffer
 				insertPos = strlen(buffer); // Set cursor to end of string
 				len = strlen(buffer);
 			}
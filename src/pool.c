@@ -0,0 +1,48 @@
+#include "pool.h"
+#include "defines.h"
+
+// Freed objects hold the link to the next free one in their first bytes
+typedef struct PoolFree PoolFree;
+struct PoolFree {
+	PoolFree *next;
+};
+
+/* Returns false if out of memory. */
+static bool _grow(Pool *p)
+{
+	unsigned char *slab = umm_malloc(p->obj_size * p->objs_per_slab);
+	size_t i;
+
+	if (slab == NULL) {
+		return false;
+	}
+	for (i = 0; i < p->objs_per_slab; i++, slab += p->obj_size) {
+		((PoolFree *)slab)->next = p->free_list;
+		p->free_list = slab;
+	}
+	p->num_allocd += p->objs_per_slab;
+	return true;
+}
+
+void *pool_alloc(Pool *p)
+{
+	PoolFree *obj;
+
+	if (p->free_list == NULL && !_grow(p)) {
+		return NULL;
+	}
+	obj = p->free_list;
+	p->free_list = obj->next;
+	if (++p->in_use > p->peak_in_use) {
+		p->peak_in_use = p->in_use;
+	}
+	return obj;
+}
+
+void pool_free(Pool *p, void *obj)
+{
+	kassert(p->in_use > 0);
+	((PoolFree *)obj)->next = p->free_list;
+	p->free_list = obj;
+	p->in_use--;
+}
@@ -0,0 +1,33 @@
+#ifndef POOL_H
+#define POOL_H
+
+/**
+ * Pool of fixed-size objects, carved out of slabs allocated from the MOS
+ * heap. Freed objects go on a free list for reuse and slabs are never given
+ * back, so allocating and freeing is O(1) and does not fragment the heap
+ * however often it happens.
+ *
+ * A pool is set up with a static initializer, e.g.
+ *   static Pool p = { NULL, sizeof(T), objs_per_slab, 0, 0, 0 };
+ * where sizeof(T) is at least the size of a pointer.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct Pool Pool;
+
+struct Pool {
+	void *free_list;
+	size_t obj_size;
+	size_t objs_per_slab;
+	size_t num_allocd; // objects in all slabs
+	size_t in_use;
+	size_t peak_in_use;
+};
+
+// Returns NULL on out-of-memory
+extern void *pool_alloc(Pool *p);
+extern void pool_free(Pool *p, void *obj);
+
+#endif /* POOL_H */
@@ -1,13 +1,36 @@
 // npf_config.c — one source file compiles the implementation.
 #define NANOPRINTF_IMPLEMENTATION
 #include "printf.h"
+#include "uart.h"
 #include <stdarg.h>
 
-extern int putch(int);
+#define KOUT_BUFLEN 64
+
+// Formatted output is collected here and written out with putblock, rather
+// than a character at a time. It is always flushed before the functions
+// that fill it return, so it never holds anything across an input wait
+static char kout_buf[KOUT_BUFLEN];
+static uint8_t kout_len;
+
+void kflush(void)
+{
+	if (kout_len) {
+		putblock(kout_buf, kout_len);
+		kout_len = 0;
+	}
+}
+
+void kputch(int c)
+{
+	kout_buf[kout_len++] = c;
+	if (kout_len == KOUT_BUFLEN) {
+		kflush();
+	}
+}
 
 static void putchar_wrapper(int c, void *userdata)
 {
-  putch(c);
+  kputch(c);
 }
 
 void kprintf(const char *format, ...)
@@ -15,4 +38,6 @@ void kprintf(const char *format, ...)
 	va_list ap;
 	va_start(ap, format);
   npf_vpprintf(&putchar_wrapper, NULL, format, ap);
+	va_end(ap);
+	kflush();
 }
@@ -18,5 +18,7 @@
 #define kvsnprintf npf_vsnprintf
 
 void kprintf(const char *format, ...) __attribute__((format(printf, 1, 2)));
+void kputch(int c);	// Buffered; call kflush before anything else is output
+void kflush(void);
 
 #endif
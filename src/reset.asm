@@ -9,6 +9,7 @@
 		.global _reset
 		.global __vector_table
 		.global ram_rst_10_handler
+		.global ram_rst_18_handler
 		.global ram_rst_08_handler
 
 		.org 0
@@ -5,7 +5,7 @@
 ; Last Updated:	26/05/2023
 
 ; Modinfo
-;
+; 16/10/2026:	Multi-block transfers (CMD18/CMD25) for runs of more than one block
 
 		;INCLUDE "ez80F92.inc"
 		INCLUDE	"equs.inc"
@@ -22,6 +22,8 @@ SD_INIT_CYCLES		.equ	10
 
 SD_START_TOKEN	.equ	0xFE
 SD_ERROR_TOKEN	.equ	0x00
+SD_MULTI_START_TOKEN	.equ	0xFC	; Start of each block of a CMD25 write
+SD_STOP_TRAN_TOKEN	.equ	0xFD	; Ends a CMD25 write
 
 SD_DATA_ACCEPTED	.equ	0x05
 SD_DATA_REJECTED_CRC	.equ	0x0B
@@ -146,8 +148,15 @@ _SD_readBlocks:
 		; sign-extend count (it's unsigned, so set top byte to 0)
 		LD		(IX+17),0
 
-		; HL := count, then jump to the check for zero
+		; Runs of two or more blocks use CMD18 (READ_MULTIPLE_BLOCK)
 		LD		HL,(IX+15)
+		LD		DE,2
+		OR		A,A
+		SBC		HL,DE
+		JP		NC,SD_readMultipleBlocks
+
+		; HL := count, then jump to the check for zero
+		ADD		HL,DE
 		JR		L_start
 		
 		; Read current block
@@ -263,6 +272,117 @@ L_out3:		CALL		_SD_CS_disable
 		RET
 
 
+
+; SD_readMultipleBlocks
+;
+; This does not use the C calling-convention.
+; It is jumped to from _SD_readBlocks when count >= 2, and returns through
+; its exit path. Reads count blocks with a single CMD18, then stops the
+; transfer with CMD12.
+
+SD_readMultipleBlocks:
+		LD		(IX-3),CMD18     | 0x40
+		LD		(IX-2),CMD18_CRC | 0x01
+
+		CALL		SD_sendIOCmd	; Sets *token to 0xFF too
+		CP		A,2
+		JR		C,L_loop9
+
+		; Command rejected, so there is no transfer to stop
+		CALL		_SD_CS_disable
+		JP		L_err_exit
+
+L_loop9:	CALL		SD_delayDisc
+
+		; Wait for the start token of the next block (timeout = 100ms)
+		TIMER_SET	0,100
+		TIMER_START	0
+
+L_loop10:	CALL		_spi_read_one
+		LD		B,A
+		CP		A,0xFF
+		JR		NZ,L_out5
+
+		TIMER_EXP	0		; (clobbers just A)
+		JR		NC,L_loop10
+
+L_out5:		TIMER_RESET	0		; (clobbers just A)
+		LD		(IX-1),B
+		LD		A,SD_START_TOKEN
+		CP		A,B
+		JR		NZ,L_err_stop
+
+		; Read the block
+		LD		BC,SD_BLOCK_LEN
+		PUSH		BC
+		LD		BC,(IX+12)	; buf
+		PUSH		BC
+		CALL		_spi_read
+		POP		BC
+		POP		BC
+
+		; Read and discard the two CRC bytes
+		CALL		_spi_read_one
+		CALL		_spi_read_one
+
+		CALL		SD_updateIOVars
+		LD		A,H
+		OR		A,L
+		JR		NZ,L_loop9
+
+		CALL		SD_stopTransmission
+		JP		L_done
+
+L_err_stop:	CALL		SD_stopTransmission
+		JP		L_err_exit
+
+
+; SD_stopTransmission
+;
+; Sends CMD12 to end a CMD18 transfer, waits for the card to go idle and
+; deasserts chip select. Chip select must already be asserted.
+
+SD_stopTransmission:
+		LD		HL,SD_CMD_LEN
+		PUSH		HL
+		LD		HL,cmd12_string
+		PUSH		HL
+		CALL		_spi_write
+		POP		HL
+		POP		HL
+
+		; Skip the stuff byte, then read the R1b response
+		CALL		_spi_read_one
+		CALL		_SD_readRes1
+		CALL		SD_waitNotBusy
+		JP		_SD_CS_disable
+
+
+; SD_waitNotBusy
+;
+; Waits for the card to release the busy signal (timeout = 500ms)
+;
+; Output: NZ if the card is ready, Z on timeout
+
+SD_waitNotBusy:
+		TIMER_SET	0,500
+		TIMER_START	0
+
+L_loop11:	CALL		_spi_read_one
+		OR		A,A
+		JR		NZ,L_out6
+
+		TIMER_EXP	0		; (clobbers just A)
+		JR		NC,L_loop11
+		XOR		A,A
+
+L_out6:		LD		B,A
+		TIMER_RESET	0		; (clobbers just A)
+		LD		A,B
+		OR		A,A
+		RET
+
+
 ; BYTE SD_writeBlocks(DWORD addr, BYTE *buf, WORD count)
 ;		     IX+6        IX+12      IX+15
 ;
@@ -280,8 +400,15 @@ _SD_writeBlocks:
 		; sign extend count (it's unsigned, so set top byte to 0)
 		LD		(IX+17),0
 
-		; HL := count, then jump to the check for zero
+		; Runs of two or more blocks use CMD25 (WRITE_MULTIPLE_BLOCK)
 		LD		HL,(IX+15)
+		LD		DE,2
+		OR		A,A
+		SBC		HL,DE
+		JP		NC,SD_writeMultipleBlocks
+
+		; HL := count, then jump to the check for zero
+		ADD		HL,DE
 		JR		L_start2
 
 L_loop6:		CALL		SD_writeSingleBlock
@@ -401,6 +528,90 @@ L_out4:		CALL		_SD_CS_disable
 		RET
 
 
+
+; SD_writeMultipleBlocks
+;
+; This does not use the C calling-convention.
+; It is jumped to from _SD_writeBlocks when count >= 2, and returns through
+; its exit path. Writes count blocks with a single CMD25, ending with the
+; stop tran token.
+
+SD_writeMultipleBlocks:
+		LD		(IX-3),CMD25     | 0x40
+		LD		(IX-2),CMD25_CRC | 0x01
+
+		CALL		SD_sendIOCmd	; Sets *token to 0xFF too
+		OR		A,A
+		JR		Z,L_loop12
+
+		; Command rejected, so there is no transfer to stop
+		CALL		_SD_CS_disable
+		JP		L_err_exit2
+
+L_loop12:	CALL		SD_delayDisc
+
+		; Send start token
+		LD		C,SD_MULTI_START_TOKEN
+		PUSH		BC
+		CALL		_spi_transfer
+		POP		BC
+
+		; Write buffer to card
+		LD		BC,SD_BLOCK_LEN
+		PUSH		BC
+		LD		BC,(IX+12)
+		PUSH		BC
+		CALL		_spi_write
+		POP		BC
+		POP		BC
+
+		; Wait for a response token (timeout = 250ms)
+		TIMER_SET	0,250
+		TIMER_START	0
+
+L_loop13:	CALL		_spi_read_one
+		LD		B,A
+		CP		A,0xFF
+		JR		NZ,L_gotit3
+
+		TIMER_EXP	0		; (clobbers just A)
+		JR		NC,L_loop13
+
+L_gotit3:	TIMER_RESET	0		; (clobbers just A)
+
+		; Abort the transfer unless the data was accepted
+		LD		A,0x1F
+		AND		A,B
+		LD		(IX-1),A
+		CP		A,SD_DATA_ACCEPTED
+		JR		NZ,L_err_stop2
+
+		; Wait for the block to be programmed
+		CALL		SD_waitNotBusy
+		JR		Z,L_err_stop2
+
+		CALL		SD_updateIOVars
+		LD		A,H
+		OR		A,L
+		JR		NZ,L_loop12
+
+		; Send stop tran token, skip a byte and wait for the card to finish
+		LD		C,SD_STOP_TRAN_TOKEN
+		PUSH		BC
+		CALL		_spi_transfer
+		POP		BC
+		CALL		_spi_read_one
+		CALL		SD_waitNotBusy
+		PUSH		AF
+		CALL		_SD_CS_disable
+		POP		AF
+		JP		NZ,L_done2
+		JP		L_err_exit2
+
+L_err_stop2:	CALL		SD_stopTransmission
+		JP		L_err_exit2
+
+
 ; SD_sendIOCmd
 ;
 ; This does not use the C calling-convention.
@@ -717,6 +928,13 @@ cmd58_string:	DB		CMD58 | 0x40
 		DB		CMD58_ARG       & 0xFF
 		DB		CMD58_CRC | 0x01
 
+cmd12_string:	DB		CMD12 | 0x40
+		DB		CMD12_ARG >> 24 & 0xFF
+		DB		CMD12_ARG >> 16 & 0xFF
+		DB		CMD12_ARG >>  8 & 0xFF
+		DB		CMD12_ARG       & 0xFF
+		DB		CMD12_CRC | 0x01
+
 		.bss
 
 sd_cmd_buffer:	DS		6
@@ -10,6 +10,16 @@
 ; 22/03/2023:	Added serial_PUTCH, moved putch and getch from uart.c
 ; 23/03/2023:	Renamed serial_RX_WAIT to seral_GETCH
 ; 29/03/2023:	Added support for UART1
+; 16/10/2026:	UART0_serial_PUTCH queues into a ring drained by the UART0 transmit interrupt
+; 16/10/2026:	Added UART0_serial_WRITE
+; 16/10/2026:	Added UART0 receive ring
+; 16/10/2026:	Added putblock
+; 16/10/2026:	UART1 is interrupt driven, with receive and transmit rings and RTS/CTS flow control
+; 16/10/2026:	Added uart1_tx_kick and uart1_rts_check
+; 16/10/2026:	Added uart0_rx_read
+; 16/10/2026:	UART0 can receive into a capture ring instead (see capture_UART0 in uart.c)
+; 16/10/2026:	UART0_serial_PUTCH and UART0_serial_WRITE clear vdp_colours_known on VDU 17 to 23
+; 16/10/2026:	Added uart1_wait
 
 			INCLUDE	"macros.inc"
 			INCLUDE	"equs.inc"
@@ -23,20 +33,43 @@
 			XDEF	UART0_serial_RX
 			XDEF	UART0_serial_GETCH
 			XDEF	UART0_serial_PUTCH 
+			XDEF	UART0_serial_WRITE
+			XDEF	UART0_TX_pump
+			XDEF	UART0_TX_kick
+			XDEF	UART0_RX_drain
+			XDEF	UART0_RX_get
 
 			XDEF	UART1_serial_TX
 			XDEF	UART1_serial_RX
 			XDEF	UART1_serial_GETCH
 			XDEF	UART1_serial_PUTCH 
+			XDEF	UART1_TX_pump
+			XDEF	UART1_TX_kick
+			XDEF	UART1_RX_drain
+			XDEF	_uart1_tx_kick
+			XDEF	_uart1_rts_check
+			XDEF	_uart1_wait
+			XDEF	_uart0_rx_read
 
 			XDEF	_uart0_putch
 			XDEF	_putch
 			XDEF	_getch 
 			
 			XDEF	putch 		
+			XDEF	_putblock
+			XDEF	putblock
 			XDEF	getch 
 
 			XREF	_serialFlags	; In globals.asm
+			XREF	_uart0RxOverruns
+			XREF	_uart0RxDropped
+			XREF	_uart0RxMaxPending
+			XREF	_uart1Rx		; In uart.c
+			XREF	_uart1Tx
+			XREF	_uart1Stats
+			XREF	_uart0Capture
+			XREF	_vdp_colours_known	; In console.c
+			XREF	idle_halt		; In misc.asm
 				
 UART0_PORT		EQU	0xC0		; UART0
 UART1_PORT		EQU	0xD0		; UART1
@@ -68,22 +101,39 @@ UART1_REG_MSR:		EQU	UART1_PORT+6	; Modem status
 UART1_REG_SCR:		EQU 	UART1_PORT+7	; Scratch
 
 TX_WAIT			EQU	16384 		; Count before a TX times out
+UART_FIFO_LEN		EQU	16		; Size of the UART transmit FIFO
 
 UART_LSR_ERR		EQU 	0x80		; Error
 UART_LSR_ETX		EQU 	0x40		; Transmit empty
 UART_LSR_ETH		EQU	0x20		; Transmit holding register empty
+UART_LSR_OE		EQU	0x02		; Overrun error
 UART_LSR_RDY		EQU	0x01		; Data ready
 
+UART_IER_TIE		EQU	0x02		; Transmit interrupt enable
+
+UART_MCR_RTS		EQU	0x02		; Request to send
+
+; Offsets into the t_serialRing structure (uart.h)
+;
+SERIAL_RING_BUF		EQU	0		; Pointer to the buffer
+SERIAL_RING_MASK	EQU	3		; Size of the buffer - 1
+SERIAL_RING_HEAD	EQU	6		; Where the next character is added
+SERIAL_RING_TAIL	EQU	9		; Where the next character is removed from
+
+; Offsets into the t_uart1Stats structure (uart.h)
+;
+UART1_STATS_OVERRUNS	EQU	0		; Characters lost to UART1 FIFO overruns
+UART1_STATS_DROPPED	EQU	3		; Characters lost because the receive ring was full
+
+UART1_RTS_OFF		EQU	32		; Drop RTS when the receive ring has less room than this
+UART1_RTS_ON		EQU	64		; And raise it again once there is at least this much
+
 ; Check whether we're clear to send (UART0 only)
 ;
 UART0_wait_CTS:		GET_GPIO	PD_DR, 8		; Check Port D, bit 3 (CTS)
 			JR		NZ, UART0_wait_CTS
 			RET
 
-UART1_wait_CTS:		GET_GPIO	PC_DR, 8		; Check Port C, bit 3 (CTS)
-			JR		NZ, UART1_wait_CTS
-			RET
-
 ; Write a character to UART0
 ; Parameters:
 ; - A: Data to write
@@ -112,31 +162,33 @@ UART0_serial_TX2:	POP		AF			; Good to send at this point, so
 			SCF					; Set the carry flag
 			RET 
 
-; Write a character to UART1
+; Queue a character to send on UART1, without waiting
 ; Parameters:
 ; - A: Data to write
 ; Returns:
-; - F: C if written
-; - F: NC if timed out
+; - F: C if queued
+; - F: NC if the transmit ring is full, or UART not enabled
 ;
-UART1_serial_TX:	PUSH		BC			; Stack BC
-			PUSH		AF 			; Stack AF
-			LD		BC,TX_WAIT		; Set CB to the transmit timeout
-UART1_serial_TX1:	IN0		A,(UART1_REG_LSR)	; Get the line status register
-			AND		UART_LSR_ETX		; Check for TX empty
-			JR		NZ, UART1_serial_TX2	; If set, then TX is empty, goto transmit
-			DEC		BC
-			LD		A, B
-			OR		C
-			JR		NZ, UART1_serial_TX1
-			POP		AF			; We've timed out at this point so
-			POP		BC			; Restore the stack
-			OR		A			; Clear the carry flag and preserve A
-			RET	
-UART1_serial_TX2:	POP		AF			; Good to send at this point, so
-			OUT0		(UART1_REG_THR),A	; Write the character to the UART transmit buffer
-			POP		BC			; Restore BC
-			SCF					; Set the carry flag
+UART1_serial_TX:	PUSH		AF
+			LD		A, (_serialFlags)	; Get the serial flags
+			TST		10h			; Check UART is enabled
+			JR		Z, UART_serial_NE	; If not, then skip
+			POP		AF
+			PUSH		BC
+			PUSH		DE
+			PUSH		HL
+			PUSH		IX
+			LD		C, A			; C: Character to write
+			LD		IX, _uart1Tx
+			CALL		serial_ring_put		; Add it to the transmit ring
+			PUSH		AF
+			CALL		UART1_TX_kick		; Make sure the transmitter is running
+			POP		AF
+			LD		A, C
+			POP		IX
+			POP		HL
+			POP		DE
+			POP		BC
 			RET 
 
 ; Read a character from UART0
@@ -152,17 +204,156 @@ UART0_serial_RX:	IN0		A,(UART0_REG_LSR)	; Get the line status register
 			SCF 					; Set the carry flag
 			RET
 
-; Read a character from UART1
+; Move everything in the UART0 receive FIFO into the receive ring
+; Called with interrupts disabled, by the UART0 interrupt handler
+; Corrupts:
+; - A, DE, HL
+;
+UART0_RX_drain:		LD	A, (_serialFlags)		; Is UART0 being captured?
+			TST	04h
+			JR	NZ, UART0_RX_capture
+UART0_RX_drain_1:	IN0	A, (UART0_REG_LSR)		; Get the line status register
+			LD	D, A
+			AND	UART_LSR_OE			; Has the FIFO overrun?
+			JR	Z, 1f
+			LD	HL, _uart0RxOverruns		; Yes, so count it
+			INC	(HL)
+			JR	NZ, 1f
+			INC	HL
+			INC	(HL)
+1:			LD	A, D				; Any characters in the FIFO?
+			AND	UART_LSR_RDY
+			JR	Z, 3f				; No, so we're done
+			LD	A, (uart0_rx_head)		; Is the ring full?
+			LD	DE, 0
+			LD	E, A				; DE: Head of the ring
+			INC	A
+			LD	HL, uart0_rx_tail
+			CP	A, (HL)
+			JR	Z, 2f
+			LD	(uart0_rx_head), A
+			LD	HL, uart0_rx_buf		; Add the character to the ring
+			ADD	HL, DE
+			IN0	A, (UART0_REG_RBR)
+			LD	(HL), A
+			JR	UART0_RX_drain_1
+2:			IN0	A, (UART0_REG_RBR)		; The ring is full, so drop the character
+			LD	HL, _uart0RxDropped		; and count it
+			INC	(HL)
+			JR	NZ, UART0_RX_drain_1
+			INC	HL
+			INC	(HL)
+			JR	UART0_RX_drain_1
+3:			LD	A, (uart0_rx_tail)		; Keep track of the most characters
+			LD	E, A				; waiting to be parsed
+			LD	A, (uart0_rx_head)
+			SUB	A, E
+			LD	HL, _uart0RxMaxPending
+			CP	A, (HL)
+			RET	C
+			LD	(HL), A
+			RET
+
+; Move everything in the UART0 receive FIFO into the capture ring
+; Overruns and dropped characters are counted as for the receive ring
+; Corrupts:
+; - A, DE, HL
+;
+UART0_RX_capture:	PUSH	BC
+			PUSH	IX
+			LD	IX, _uart0Capture
+1:			IN0	A, (UART0_REG_LSR)		; Get the line status register
+			LD	B, A
+			AND	UART_LSR_OE			; Has the FIFO overrun?
+			JR	Z, 2f
+			LD	HL, _uart0RxOverruns		; Yes, so count it
+			INC	(HL)
+			JR	NZ, 2f
+			INC	HL
+			INC	(HL)
+2:			LD	A, B				; Any characters in the FIFO?
+			AND	UART_LSR_RDY
+			JR	Z, 3f				; No, so we're done
+			IN0	C, (UART0_REG_RBR)		; Add the character to the ring
+			CALL	serial_ring_put
+			JR	C, 1b
+			LD	HL, _uart0RxDropped		; The ring is full, so count it as dropped
+			INC	(HL)
+			JR	NZ, 1b
+			INC	HL
+			INC	(HL)
+			JR	1b
+3:			POP	IX
+			POP	BC
+			RET
+
+; Take a character from the UART0 receive ring
+; Returns:
+; - A: Data read
+; - F: C if character read
+; - F: NC if the ring is empty
+; Corrupts:
+; - DE, HL
+;
+UART0_RX_get:		LD	A, (uart0_rx_tail)		; Is the ring empty?
+			LD	HL, uart0_rx_head
+			CP	A, (HL)
+			RET	Z				; Yes, so return with NC
+			LD	DE, 0
+			LD	E, A
+			INC	A
+			LD	(uart0_rx_tail), A
+			LD	HL, uart0_rx_buf
+			ADD	HL, DE
+			LD	A, (HL)
+			SCF					; Set the carry flag
+			RET
+
+; Read a character from the UART1 receive ring, without waiting
 ; Returns:
 ; - A: Data read
 ; - F: C if character read
 ; - F: NC if no character read
 ;
-UART1_serial_RX:	IN0		A,(UART1_REG_LSR)	; Get the line status register
-			AND 		UART_LSR_RDY		; Check for characters in buffer
-			RET		Z			; Just ret (with carry clear) if no characters
-			IN0		A,(UART1_REG_RBR)	; Read the character from the UART receive buffer
-			SCF 					; Set the carry flag
+UART1_serial_RX:	PUSH		DE
+			PUSH		HL
+			PUSH		IX
+			LD		IX, _uart1Rx
+			CALL		serial_ring_get		; Take a character from the ring
+			JR		NC, 1f
+			PUSH		AF
+			CALL		UART1_RTS_check		; Raise RTS again if there is room now
+			POP		AF
+1:			POP		IX
+			POP		HL
+			POP		DE
+			RET
+
+; Raise RTS if flow control dropped it and the receive ring has room again
+; IX: Pointer to the UART1 receive ring
+; Corrupts:
+; - A, DE, HL
+;
+UART1_RTS_check:	LD		A, (_serialFlags)	; If hardware flow control enabled then
+			TST		20h
+			RET		Z
+			LD		A, I			; P/V: IFF2, so whether interrupts are enabled
+			DI
+			PUSH		AF
+			IN0		A, (UART1_REG_MCR)	; Is RTS dropped?
+			TST		UART_MCR_RTS
+			JR		NZ, 1f
+			CALL		serial_ring_room	; Is there room in the ring now?
+			LD		DE, UART1_RTS_ON
+			OR		A, A
+			SBC		HL, DE
+			JR		C, 1f
+			IN0		A, (UART1_REG_MCR)	; Yes, so raise it
+			OR		A, UART_MCR_RTS
+			OUT0		(UART1_REG_MCR), A
+1:			POP		AF
+			RET		PO			; Interrupts were disabled, so leave them that way
+			EI
 			RET
 
 ; Read a character from UART0 (blocking)
@@ -188,14 +379,16 @@ UART0_serial_GETCH:	PUSH		AF
 ;
 UART1_serial_GETCH:	PUSH		AF 
 			LD		A, (_serialFlags)
-			TST		01h
+			TST		10h
 			JR		Z, UART_serial_NE
 			POP		AF
 1:			CALL 		UART1_serial_RX
 			JR		NC,1b
 			RET 
 
-; Write a character to UART0 (blocking)
+; Write a character to UART0
+; The character is queued in the transmit ring, which the UART0 transmit
+; interrupt drains, so this only blocks while the ring is full
 ; Parameters:
 ; - A: Character to write out
 ; Returns:
@@ -206,14 +399,163 @@ UART0_serial_PUTCH:	PUSH	AF
 			LD	A, (_serialFlags)		; Get the serial flags
 			TST	01h				; Check UART is enabled
 			JR	Z, UART_serial_NE		; If not, then skip
-			TST	02h				; If hardware flow control enabled then
-			CALL	NZ, UART0_wait_CTS		; Wait for clear to send signal
 			POP	AF
-1:			CALL	UART0_serial_TX			; Send the character
-			JR	NC, 1b				; Repeat until sent
+			PUSH	BC
+			PUSH	DE
+			PUSH	HL
+			LD	C, A				; C: Character to write
+			SUB	A, 17				; VDU 17 to 23 might change the text colours
+			CP	A, 7
+			JR	NC, 1f
+			XOR	A, A				; So forget the shadowed ones
+			LD	(_vdp_colours_known), A
+1:			LD	A, (uart0_tx_head)		; B: Head of the ring after this character
+			INC	A
+			LD	B, A
+			LD	A, (uart0_tx_tail)		; Is the ring full?
+			CP	A, B
+			JR	NZ, 2f
+			CALL	UART0_TX_kick			; Yes, so drain it from here, in case
+			JR	1b				; interrupts are disabled
+2:			LD	HL, uart0_tx_buf		; Add the character to the ring
+			LD	DE, 0
+			LD	A, (uart0_tx_head)
+			LD	E, A
+			ADD	HL, DE
+			LD	(HL), C
+			LD	A, B
+			LD	(uart0_tx_head), A
+			CALL	UART0_TX_kick			; Make sure the transmitter is running
+			LD	A, C
+			POP	HL
+			POP	DE
+			POP	BC
+			SCF					; Set the carry flag
+			RET
+
+; Write a block of characters to UART0
+; The block is copied into the transmit ring, starting the transmitter
+; every FIFO's worth, so this only blocks while the ring is full
+; Parameters:
+; - HL: Buffer address
+; - BC: Number of characters to write (must not be 0)
+; Returns:
+; - F: C if written
+; - F: NC if UART not enabled
+; Corrupts:
+; - A, BC, HL
+;
+UART0_serial_WRITE:	LD	A, (_serialFlags)		; Get the serial flags
+			TST	01h				; Check UART is enabled
+			RET	Z				; If not, then return with NC
+			PUSH	DE
+			PUSH	IX
+1:			LD	A, (uart0_tx_head)		; Is the ring full?
+			LD	DE, 0
+			LD	E, A				; DE: Head of the ring
+			INC	A
+			PUSH	HL
+			LD	HL, uart0_tx_tail
+			CP	A, (HL)
+			POP	HL
+			JR	Z, 3f
+			LD	IX, uart0_tx_buf		; Add the character to the ring
+			ADD	IX, DE
+			LD	D, A
+			LD	A, (HL)
+			LD	(IX+0), A
+			SUB	A, 17				; VDU 17 to 23 might change the text colours
+			CP	A, 7
+			JR	NC, 4f
+			XOR	A, A				; So forget the shadowed ones
+			LD	(_vdp_colours_known), A
+4:			LD	A, D
+			LD	(uart0_tx_head), A
+			INC	HL
+			DEC	BC
+			AND	A, UART_FIFO_LEN-1		; Another FIFO's worth queued?
+			JR	NZ, 2f
+			PUSH	BC
+			PUSH	HL
+			CALL	UART0_TX_kick			; Yes, so make sure the transmitter is running
+			POP	HL
+			POP	BC
+2:			LD	A, B				; Any more to write?
+			OR	A, C
+			JR	NZ, 1b
+			PUSH	BC
+			PUSH	HL
+			CALL	UART0_TX_kick			; Send whatever is left over
+			POP	HL
+			POP	BC
+			POP	IX
+			POP	DE
+			SCF					; Set the carry flag
+			RET
+3:			PUSH	BC				; The ring is full, so drain it from here
+			PUSH	HL
+			CALL	UART0_TX_kick
+			POP	HL
+			POP	BC
+			JR	1b
+
+; Start UART0 sending from the transmit ring, if it is not already
+; Can be called with interrupts enabled or disabled
+; Corrupts:
+; - A, B, DE, HL
+;
+UART0_TX_kick:		LD	A, I				; P/V: IFF2, so whether interrupts are enabled
+			DI
+			PUSH	AF
+			CALL	UART0_TX_pump
+			POP	AF
+			RET	PO				; They were disabled, so leave them that way
+			EI
+			RET
+
+; Move characters from the transmit ring to the UART0 FIFO
+; Called with interrupts disabled, by the UART0 and VBLANK interrupt handlers
+; and UART0_TX_kick. The transmit interrupt is left enabled only while there
+; is more to send and the ESP32 is clear to receive it. If flow control
+; stalls sending, the VBLANK handler restarts it
+; Corrupts:
+; - A, B, DE, HL
+;
+UART0_TX_pump:		IN0	A, (UART0_REG_LSR)		; Is the FIFO empty yet?
+			AND	UART_LSR_ETH
+			JR	Z, UART0_TX_pump_more		; No, so wait for the interrupt
+			LD	B, UART_FIFO_LEN		; Up to a FIFO's worth
+1:			LD	A, (uart0_tx_tail)		; Is the ring empty?
+			LD	HL, uart0_tx_head
+			CP	A, (HL)
+			JR	Z, UART0_TX_pump_stop
+			LD	DE, 0
+			LD	E, A				; DE: Tail of the ring
+			LD	A, (_serialFlags)		; If hardware flow control enabled then
+			TST	02h
+			JR	Z, 2f
+			GET_GPIO	PD_DR, 8		; check for clear to send
+			JR	NZ, UART0_TX_pump_stop
+2:			LD	HL, uart0_tx_buf		; Send the character
+			ADD	HL, DE
+			LD	A, (HL)
+			OUT0	(UART0_REG_THR), A
+			LD	A, E
+			INC	A
+			LD	(uart0_tx_tail), A
+			DJNZ	1b
+UART0_TX_pump_more:	IN0	A, (UART0_REG_IER)		; Interrupt when the FIFO is empty
+			OR	A, UART_IER_TIE
+			OUT0	(UART0_REG_IER), A
+			RET
+UART0_TX_pump_stop:	IN0	A, (UART0_REG_IER)		; Nothing to send for now
+			AND	A, ~UART_IER_TIE & 0xFF
+			OUT0	(UART0_REG_IER), A
 			RET
 
-; Write a character to UART1 (blocking)
+; Write a character to UART1
+; The character is queued in the transmit ring, which the UART1 transmit
+; interrupt drains, so this only blocks while the ring is full
 ; Parameters:
 ; - A: Character to write out
 ; Returns:
@@ -224,11 +566,176 @@ UART1_serial_PUTCH:	PUSH	AF
 			LD	A, (_serialFlags)		; Get the serial flags
 			TST	10h				; Check UART is enabled
 			JR	Z, UART_serial_NE		; If not, then skip (reuses UART0 routine here)
-			TST	20h				; If hardware flow control enabled then
-			CALL	NZ, UART1_wait_CTS		; Wait for clear to send signal
 			POP	AF			
-1:			CALL	UART1_serial_TX			; Send the character
-			JR	NC, 1b				; Repeat until sent
+1:			CALL	UART1_serial_TX			; Queue the character
+			JR	NC, 1b				; Repeat until there is room
+			RET
+
+; Start UART1 sending from the transmit ring, if it is not already
+; Can be called with interrupts enabled or disabled
+; Corrupts:
+; - A, B, DE, HL
+;
+UART1_TX_kick:		LD	A, I				; P/V: IFF2, so whether interrupts are enabled
+			DI
+			PUSH	AF
+			PUSH	IX
+			CALL	UART1_TX_pump
+			POP	IX
+			POP	AF
+			RET	PO				; They were disabled, so leave them that way
+			EI
+			RET
+
+; Move characters from the transmit ring to the UART1 FIFO
+; Called with interrupts disabled, by the UART1 and VBLANK interrupt handlers
+; and UART1_TX_kick. As with UART0, the transmit interrupt is only left enabled
+; while there is more to send and CTS allows it
+; Corrupts:
+; - A, B, DE, HL, IX
+;
+UART1_TX_pump:		IN0	A, (UART1_REG_LSR)		; Is the FIFO empty yet?
+			AND	UART_LSR_ETH
+			JR	Z, UART1_TX_pump_more		; No, so wait for the interrupt
+			LD	IX, _uart1Tx
+			LD	B, UART_FIFO_LEN		; Up to a FIFO's worth
+1:			LD	A, (_serialFlags)		; If hardware flow control enabled then
+			TST	20h
+			JR	Z, 2f
+			GET_GPIO	PC_DR, 8		; check for clear to send
+			JR	NZ, UART1_TX_pump_stop
+2:			CALL	serial_ring_get			; Anything left to send?
+			JR	NC, UART1_TX_pump_stop
+			OUT0	(UART1_REG_THR), A
+			DJNZ	1b
+UART1_TX_pump_more:	IN0	A, (UART1_REG_IER)		; Interrupt when the FIFO is empty
+			OR	A, UART_IER_TIE
+			OUT0	(UART1_REG_IER), A
+			RET
+UART1_TX_pump_stop:	IN0	A, (UART1_REG_IER)		; Nothing to send for now
+			AND	A, ~UART_IER_TIE & 0xFF
+			OUT0	(UART1_REG_IER), A
+			RET
+
+; Empty the UART1 receive FIFO into the receive ring
+; Called with interrupts disabled, by the UART1 interrupt handler
+; Characters lost to FIFO overruns or a full ring are counted in _uart1Stats
+; If hardware flow control is enabled, RTS is dropped while the ring is nearly full
+; Corrupts:
+; - A, BC, DE, HL, IX
+;
+UART1_RX_drain:		LD	IX, _uart1Rx
+1:			IN0	A, (UART1_REG_LSR)		; Get the line status register
+			LD	B, A
+			AND	UART_LSR_OE			; Has the FIFO overrun?
+			JR	Z, 2f
+			LD	HL, (_uart1Stats + UART1_STATS_OVERRUNS)
+			INC	HL
+			LD	(_uart1Stats + UART1_STATS_OVERRUNS), HL
+2:			LD	A, B
+			AND	UART_LSR_RDY			; Any more characters in the FIFO?
+			JR	Z, 3f
+			IN0	C, (UART1_REG_RBR)		; Read the character
+			CALL	serial_ring_put			; And add it to the ring
+			JR	C, 1b
+			LD	HL, (_uart1Stats + UART1_STATS_DROPPED)
+			INC	HL				; No room, so count it as dropped
+			LD	(_uart1Stats + UART1_STATS_DROPPED), HL
+			JR	1b
+3:			LD	A, (_serialFlags)		; If hardware flow control enabled then
+			TST	20h
+			RET	Z
+			CALL	serial_ring_room		; check whether the ring is nearly full
+			LD	DE, UART1_RTS_OFF
+			OR	A, A
+			SBC	HL, DE
+			RET	NC
+			IN0	A, (UART1_REG_MCR)		; It is, so drop RTS
+			AND	A, ~UART_MCR_RTS & 0xFF
+			OUT0	(UART1_REG_MCR), A
+			RET
+
+; Add a character to a ring
+; The ring buffer size is a power of 2, and one slot is always left free,
+; so head == tail means the ring is empty
+; Parameters:
+; - IX: Pointer to a t_serialRing
+; - C: Character to add
+; Returns:
+; - F: C if added
+; - F: NC if the ring is full
+; Corrupts:
+; - A, DE, HL
+;
+serial_ring_put:	LD	DE, (IX+SERIAL_RING_HEAD)
+			LD	HL, (IX+SERIAL_RING_BUF)	; The head slot is always free, so
+			ADD	HL, DE				; store the character there first
+			LD	(HL), C
+			INC	DE				; DE: Head of the ring after this character
+			LD	A, E
+			AND	A, (IX+SERIAL_RING_MASK+0)
+			LD	E, A
+			LD	A, D
+			AND	A, (IX+SERIAL_RING_MASK+1)
+			LD	D, A
+			LD	HL, (IX+SERIAL_RING_TAIL)	; Is the ring full?
+			OR	A, A
+			SBC	HL, DE
+			RET	Z				; Yes, so return with NC
+			LD	(IX+SERIAL_RING_HEAD), DE	; No, so commit the character
+			SCF
+			RET
+
+; Take a character from a ring
+; Parameters:
+; - IX: Pointer to a t_serialRing
+; Returns:
+; - A: Character
+; - F: C if a character was read
+; - F: NC if the ring is empty
+; Corrupts:
+; - DE, HL
+;
+serial_ring_get:	LD	DE, (IX+SERIAL_RING_TAIL)
+			LD	HL, (IX+SERIAL_RING_HEAD)	; Is the ring empty?
+			OR	A, A
+			SBC	HL, DE
+			RET	Z				; Yes, so return with NC
+			LD	HL, (IX+SERIAL_RING_BUF)
+			ADD	HL, DE
+			INC	DE				; DE: Tail of the ring after this character
+			LD	A, E
+			AND	A, (IX+SERIAL_RING_MASK+0)
+			LD	E, A
+			LD	A, D
+			AND	A, (IX+SERIAL_RING_MASK+1)
+			LD	D, A
+			LD	A, (HL)
+			LD	(IX+SERIAL_RING_TAIL), DE
+			SCF
+			RET
+
+; Get the free space in a ring
+; Parameters:
+; - IX: Pointer to a t_serialRing
+; Returns:
+; - HL: Number of characters that can be added
+; Corrupts:
+; - A, DE
+;
+serial_ring_room:	LD	HL, (IX+SERIAL_RING_HEAD)	; Characters in the ring are
+			LD	DE, (IX+SERIAL_RING_TAIL)	; (head - tail) & mask
+			OR	A, A
+			SBC	HL, DE
+			LD	A, L
+			AND	A, (IX+SERIAL_RING_MASK+0)
+			LD	E, A
+			LD	A, H
+			AND	A, (IX+SERIAL_RING_MASK+1)
+			LD	D, A
+			LD	HL, (IX+SERIAL_RING_MASK)	; The room is mask - that
+			OR	A, A
+			SBC	HL, DE
 			RET
 
 ; Called by UART0 and UART1 PUTCH and GETCH if the UART is not enabled
@@ -275,6 +782,162 @@ putch:			PUSH	IY				; Standard C prologue
 			POP	IY
 			RET
 
+; void putblock(const char *buf, INT len);
+;
+; Write a block of characters out through rst 0x18
+; Parameters:
+; - buf: Pointer to the characters
+; - len: The number of characters to write
+;
+_putblock:
+putblock:		PUSH	IY				; Standard C prologue
+			LD	IY, 0
+			ADD	IY, SP	
+
+			LD	BC, (IY+9)			; INT len
+			LD	A, B				; Nothing to do if it is 0, as
+			OR	A, C				; rst 0x18 would treat that as delimited
+			JR	Z, 1f
+			LD	HL, (IY+6)			; const char * buf
+			CALL.LIL	ram_rst_18_handler		; Output the block
+
+1:			LD 	SP, IY				; Standard epilogue
+			POP	IY
+			RET
+
+; void uart1_tx_kick(void);
+;
+; Start UART1 sending, after characters have been added to the transmit ring
+;
+_uart1_tx_kick:		JP	UART1_TX_kick			; Preserves IX
+
+; void uart1_rts_check(void);
+;
+; Raise RTS again if needed, after characters have been taken from the receive ring
+;
+_uart1_rts_check:	PUSH	IX
+			LD	IX, _uart1Rx
+			CALL	UART1_RTS_check
+			POP	IX
+			RET
+
+; uint8_t uart1_wait(uint8_t tx);
+;
+; Check whether UART1 can go on: whether there are characters in the receive
+; ring, or with tx set, room in the transmit ring. If not, sleep until the next
+; interrupt, as wait_event does. If interrupts are disabled, the UART1 handler
+; can't run, so empty the receive FIFO or fill the transmit FIFO here instead
+; Parameters:
+; - tx: 0 to wait to receive, 1 to wait to send
+; Returns:
+; - WAIT_EVENT_SET (1) if it can
+; - WAIT_EVENT_NONE (0) if not, after sleeping until an interrupt
+; - WAIT_EVENT_POLLED (2) if not, and interrupts are disabled
+;
+_uart1_wait:		PUSH	IY				; Standard C prologue
+			LD	IY, 0
+			ADD	IY, SP
+			PUSH	IX
+			LD	A, I				; P/V: Whether interrupts are enabled
+			PUSH	AF
+			DI
+			LD	A, (IY+6)			; uint8_t tx
+			OR	A, A
+			JR	NZ, 1f
+			LD	IX, _uart1Rx			; Any characters in the receive ring?
+			LD	HL, (IX+SERIAL_RING_HEAD)
+			LD	DE, (IX+SERIAL_RING_TAIL)
+			OR	A, A
+			SBC	HL, DE
+			JR	NZ, 3f
+			POP	AF				; No, so if interrupts are enabled
+			JP	PE, 2f				; then sleep until the next one
+			CALL	UART1_RX_drain			; Otherwise empty the FIFO here
+			JR	5f
+1:			LD	IX, _uart1Tx			; Any room in the transmit ring?
+			CALL	serial_ring_room
+			LD	DE, 0
+			OR	A, A
+			SBC	HL, DE
+			JR	NZ, 3f
+			POP	AF				; No, so if interrupts are enabled
+			JP	PE, 2f				; then sleep until the next one
+			CALL	UART1_TX_pump			; Otherwise fill the FIFO here
+5:			LD	A, 2				; Return WAIT_EVENT_POLLED
+			JR	6f
+2:			CALL	idle_halt
+			XOR	A, A				; Return WAIT_EVENT_NONE
+			JR	6f
+3:			POP	AF				; Yes, so re-enable interrupts if they were
+			JP	PO, 4f
+			EI
+4:			LD	A, 1				; And return WAIT_EVENT_SET
+6:			POP	IX
+			LD	SP, IY				; Standard epilogue
+			POP	IY
+			RET
+
+; uint8_t uart0_rx_read(uint8_t *buf, uint8_t len);
+;
+; Copy characters out of the UART0 receive ring, without waiting
+; Only for use while _uart0_rx_parsing is set, so the UART0 handler is not
+; also taking them out to parse as VDP packets
+; Parameters:
+; - buf: Where to copy them to
+; - len: The most to copy
+; Returns:
+; - The number of characters copied
+;
+_uart0_rx_read:		PUSH	IY				; Standard C prologue
+			LD	IY, 0
+			ADD	IY, SP
+
+			LD	DE, (IY+6)			; DE: uint8_t * buf
+1:			LD	A, (IY+9)			; A: Characters still wanted
+			OR	A, A
+			JR	Z, 4f
+			LD	BC, 0
+			LD	C, A				; C: How many to copy this time
+			LD	A, (uart0_rx_head)		; How many are in the ring?
+			LD	HL, uart0_rx_tail
+			SUB	A, (HL)
+			JR	Z, 4f				; None, so done
+			CP	A, C
+			JR	NC, 2f
+			LD	C, A
+2:			LD	A, (HL)				; How many before the end of the buffer?
+			NEG
+			JR	Z, 3f				; All of them if the tail is at the start
+			CP	A, C
+			JR	NC, 3f
+			LD	C, A
+3:			LD	A, (IY+9)			; Take them off what is wanted
+			SUB	A, C
+			LD	(IY+9), A
+			LD	A, (HL)				; HL: Tail of the ring in the buffer
+			LD	HL, uart0_rx_buf
+			PUSH	BC
+			LD	BC, 0
+			LD	C, A
+			ADD	HL, BC
+			POP	BC
+			ADD	A, C				; Where the tail will be after the copy
+			PUSH	AF
+			LDIR					; Copy them
+			POP	AF
+			LD	(uart0_rx_tail), A
+			JR	1b
+
+4:			EX	DE, HL				; Return how many were copied
+			LD	DE, (IY+6)
+			OR	A, A
+			SBC	HL, DE
+			LD	A, L
+
+			LD 	SP, IY				; Standard epilogue
+			POP	IY
+			RET
+
 ; INT getch(VOID);
 ;
 ; Read a character out to the UART - waits for character input
@@ -293,3 +956,17 @@ getch:			PUSH	IY				; Standard C prologue
 			LD 	SP, IY				; Standard epilogue
 			POP	IY
 			RET
+
+			.bss
+
+; UART0 transmit ring. The indexes wrap at 256
+;
+uart0_tx_buf:		DS	256
+uart0_tx_head:		DS	1		; Where the next character is added
+uart0_tx_tail:		DS	1		; Where the next character is sent from
+
+; UART0 receive ring, filled by the UART0 interrupt handler
+;
+uart0_rx_buf:		DS	256
+uart0_rx_head:		DS	1		; Where the next character is added
+uart0_rx_tail:		DS	1		; Where the next character is parsed from
@@ -0,0 +1,329 @@
+/*
+ * Binary sideload
+ *
+ * A faster alternative to the hex records of hxload_vdp. The VDP is asked
+ * to pass bytes through untouched (VDU 23,28,'B'), and the sender then
+ * sends the program in blocks, each of which is copied straight from the
+ * UART0 receive ring to its load address. The UART0 handler is told to
+ * leave the ring alone while this happens, so none of it goes through the
+ * VDP protocol or the keyboard buffer.
+ *
+ * MOS starts by sending 'R', the largest block it takes (16-bit) and the
+ * window. Each block is then
+ *
+ *   type (1: data, 0: end), address (24-bit), length (16-bit), sequence,
+ *   CRC of those 7 bytes (16-bit), then length bytes of data and their CRC
+ *
+ * with everything little endian, and the CRCs CRC-16/CCITT starting from
+ * 0xFFFF. MOS replies to each block with ACK and its sequence number. The
+ * sender may have up to a window of blocks waiting for an ACK. After an
+ * error MOS waits for the line to go quiet and replies NAK with the
+ * sequence number it wants next; the sender goes back to that block.
+ *
+ * The VDP leaves pass-through mode once the end block has been ACKed. If
+ * MOS gives up instead (a timeout, a block it will not take, or a failed
+ * write) it replies CAN with the sequence number, and then sends VDU
+ * 23,28,'E' for the VDP to leave pass-through mode. Replies are always a
+ * reply byte and a sequence number, so 28 never follows 23 in them.
+ *
+ * When sideloading to a file the address is the offset into the file
+ * instead, and must follow on from the last block. The file must not
+ * already exist, and is deleted again if the sideload fails. The end
+ * block is only ACKed once the file has been written and closed. UART0 is captured into
+ * a large ring for this, so nothing is lost while the SD card is written.
+ * Blocks are gathered into one half of a double buffer; once that is full
+ * it is written out a slice at a time, whenever there is nothing else to
+ * do, while the other half fills.
+ */
+#include "sideload.h"
+#include "config.h"
+#include "globals.h"
+#include "mos.h"
+#include "uart.h"
+#include "../src_fatfs/ff.h"
+
+#define SIDELOAD_BLOCK_MAX 1024	    // Largest block the sender may send
+#define SIDELOAD_WINDOW 4	    // Blocks the sender may send before it waits for an ACK
+#define SIDELOAD_START_TIMEOUT 3000 // Centiseconds to wait for the sender to start
+#define SIDELOAD_TIMEOUT 500	    // Centiseconds with nothing received before giving up
+#define SIDELOAD_QUIET 4	    // Centiseconds the line must be quiet for after an error
+#define SIDELOAD_RAM_START 0x040000
+#define SIDELOAD_RAM_END ((uint24_t)__MOS_systemAddress) // Stops short of the MOS stack and data, as LOAD does
+
+#define SIDELOAD_READY 'R'
+#define SIDELOAD_ACK 0x06
+#define SIDELOAD_NAK 0x15
+#define SIDELOAD_ABORT 0x18	    // CAN
+
+#define SIDELOAD_TYPE_END 0
+#define SIDELOAD_TYPE_DATA 1
+
+#define SIDELOAD_HEADER_LEN 9
+
+#define SIDELOAD_WRITE_SLICE 2048   // Most written to the file at once, so the capture ring keeps up
+
+// The half of the double buffer being written to the file
+//
+static FIL *sideload_fil;
+static const uint8_t *sideload_wbuf;
+static uint24_t sideload_wlen;
+static uint8_t sideload_wresult;
+
+// Write the next slice of the half being written, if there is one
+//
+static void sideload_write_slice(void)
+{
+	const uint24_t len = sideload_wlen > SIDELOAD_WRITE_SLICE ? SIDELOAD_WRITE_SLICE : sideload_wlen;
+	UINT bw;
+
+	if (len == 0 || sideload_wresult != FR_OK) {
+		return;
+	}
+	sideload_wresult = f_write(sideload_fil, sideload_wbuf, len, &bw);
+	if (sideload_wresult == FR_OK && bw != len) {
+		sideload_wresult = FR_DENIED; // The card is full
+	}
+	if (sideload_wresult != FR_OK) {
+		sideload_wlen = 0; // Nothing more will be written
+		return;
+	}
+	sideload_wbuf += len;
+	sideload_wlen -= len;
+}
+
+// Take received bytes, from the capture ring if there is one
+//
+static uint24_t sideload_rx(uint8_t *buf, uint24_t len)
+{
+	if (uart0Capture.buf) {
+		return serial_ring_read(&uart0Capture, buf, len);
+	}
+	return uart0_rx_read(buf, len > 255 ? 255 : len);
+}
+
+// Receive a number of bytes, writing to the file while waiting for them
+// Parameters:
+// - buf: Where to put them
+// - len: How many
+// - timeout: Centiseconds to wait for each part of them
+// - crc: If not NULL, the CRC to run over them as they arrive, so there is
+//   no pause to check them afterwards while the ring fills up
+// Returns:
+// - false if they stopped coming, or writing to the file failed
+//
+static bool sideload_recv(uint8_t *buf, uint24_t len, uint24_t timeout, uint16_t *crc)
+{
+	uint32_t last = clock;
+
+	while (len) {
+		const uint24_t n = sideload_rx(buf, len);
+		if (n) {
+			if (crc) {
+				*crc = crc16(*crc, buf, n);
+			}
+			buf += n;
+			len -= n;
+			last = clock;
+		} else if (sideload_wresult != FR_OK) {
+			return false;
+		} else if (sideload_wlen) {
+			sideload_write_slice();
+			last = clock; // The sender may be waiting on ACKs we haven't read yet
+		} else if (clock - last >= timeout) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Reply to a block
+//
+static void sideload_reply(uint8_t reply, uint8_t seq)
+{
+	uart0_putch(reply);
+	uart0_putch(seq);
+}
+
+// Throw away whatever else the sender has sent after an error, then ask for
+// the block we want next
+//
+static void sideload_nak(uint8_t seq)
+{
+	uint8_t scratch[16];
+	uint32_t last = clock;
+
+	while (clock - last < SIDELOAD_QUIET) {
+		if (sideload_rx(scratch, sizeof(scratch))) {
+			last = clock;
+		}
+	}
+	sideload_reply(SIDELOAD_NAK, seq);
+}
+
+// Tell the sender that MOS has given up, and take the VDP out of
+// pass-through mode
+//
+static void sideload_abort(uint8_t seq)
+{
+	sideload_reply(SIDELOAD_ABORT, seq);
+	uart0_putch(23);
+	uart0_putch(28);
+	uart0_putch('E');
+}
+
+// Hand the filled half of the double buffer over to be written, once the
+// other half has been
+// Parameters:
+// - buf: The half
+// - len: The number of bytes in it
+//
+static void sideload_write(const uint8_t *buf, uint24_t len)
+{
+	while (sideload_wlen && sideload_wresult == FR_OK) {
+		sideload_write_slice();
+	}
+	sideload_wbuf = buf;
+	sideload_wlen = len;
+}
+
+// Receive a program or file with the binary sideload protocol
+// Parameters:
+// - filename: The file to write, or NULL to load to the addresses in the blocks
+// - stats: Filled in with what was received, and how fast
+// Returns:
+// - FR_OK if the sender finished, SIDELOAD_STOPPED if it stopped sending, or a FatFS error
+//   (FR_EXIST if the file is already there)
+//
+uint8_t sideload_binary(const char *filename, t_sideloadStats *stats)
+{
+	uint8_t *const halves = (uint8_t *)MOS_sideloadBuffer + MOS_sideloadBufferSize;
+	uint8_t hdr[SIDELOAD_HEADER_LEN];
+	uint8_t crc[2];
+	uint8_t seq = 0;
+	uint8_t half = 0;	 // The half of the double buffer being filled
+	uint24_t fill = 0;	 // and how much is in it
+	uint24_t timeout = SIDELOAD_START_TIMEOUT;
+	uint32_t start = 0;
+	uint8_t result = SIDELOAD_STOPPED;
+	uint8_t fr;
+	FIL fil;
+
+	stats->bytes = 0;
+	stats->blocks = 0;
+	stats->retries = 0;
+	stats->time = 0;
+
+	if (filename) {
+		result = f_open(&fil, filename, FA_WRITE | FA_CREATE_NEW);
+		if (result != FR_OK) {
+			return result;
+		}
+		result = SIDELOAD_STOPPED;
+		sideload_fil = &fil;
+	}
+	sideload_wlen = 0;
+	sideload_wresult = FR_OK;
+
+	uart0_putch(23); // Put the VDP into binary sideload mode
+	uart0_putch(28);
+	uart0_putch('B');
+
+	uart0_rx_parsing = 1; // The UART0 handler now leaves the receive ring to us
+	if (filename) {
+		capture_UART0((uint8_t *)MOS_sideloadBuffer, MOS_sideloadBufferSize);
+	}
+	uart0_putch(SIDELOAD_READY);
+	uart0_putch(SIDELOAD_BLOCK_MAX & 0xFF);
+	uart0_putch(SIDELOAD_BLOCK_MAX >> 8);
+	uart0_putch(SIDELOAD_WINDOW);
+
+	while (sideload_recv(hdr, sizeof(hdr), timeout, NULL)) {
+		const uint8_t type = hdr[0];
+		const uint24_t addr = hdr[1] | (hdr[2] << 8) | ((uint24_t)hdr[3] << 16);
+		const uint24_t len = hdr[4] | (hdr[5] << 8);
+		uint16_t data_crc = 0xFFFF;
+		uint8_t *dest;
+
+		if (timeout == SIDELOAD_START_TIMEOUT) {
+			timeout = SIDELOAD_TIMEOUT;
+			start = clock;
+		}
+		if (crc16(0xFFFF, hdr, 7) != (hdr[7] | (hdr[8] << 8)) || type > SIDELOAD_TYPE_DATA || len > SIDELOAD_BLOCK_MAX) {
+			stats->retries++; // Can't trust the length, so resynchronise
+			sideload_nak(seq);
+			continue;
+		}
+		if (hdr[6] != seq) { // Sent after one we NAKed, so ignore it
+			sideload_nak(seq);
+			continue;
+		}
+		if (type == SIDELOAD_TYPE_END) { // ACKed below, once the file is safe
+			result = FR_OK;
+			break;
+		}
+		if (filename) {
+			if (addr != stats->bytes) { // Files are sent in order
+				sideload_nak(seq);
+				continue;
+			}
+			if (fill + len > MOS_sideloadBufferSize) { // No room in this half, so start on the other
+				sideload_write(halves + half * MOS_sideloadBufferSize, fill);
+				half ^= 1;
+				fill = 0;
+			}
+			dest = halves + half * MOS_sideloadBufferSize + fill;
+		} else {
+			if (addr < SIDELOAD_RAM_START || addr > SIDELOAD_RAM_END || len > SIDELOAD_RAM_END - addr) {
+				result = MOS_OVERLAPPING_SYSTEM; // Refused with CAN below
+				break;
+			}
+			dest = (uint8_t *)addr;
+		}
+		if (!sideload_recv(dest, len, timeout, &data_crc) || !sideload_recv(crc, sizeof(crc), timeout, NULL)) {
+			break;
+		}
+		if (data_crc != (crc[0] | (crc[1] << 8))) {
+			stats->retries++;
+			sideload_nak(seq);
+			continue;
+		}
+		sideload_reply(SIDELOAD_ACK, seq++);
+		fill += len;
+		stats->bytes += len;
+		stats->blocks++;
+		if (filename && sideload_wresult != FR_OK) {
+			break;
+		}
+	}
+
+	if (filename) {
+		if (result == FR_OK) {
+			sideload_write(halves + half * MOS_sideloadBufferSize, fill); // Write what is left
+			sideload_write(NULL, 0);
+		}
+		if (sideload_wresult != FR_OK) {
+			result = sideload_wresult;
+		}
+		fr = f_close(&fil);
+		if (result == FR_OK) {
+			result = fr;
+		}
+		if (result != FR_OK) {
+			f_unlink(filename); // Don't leave a partial file behind
+		}
+	}
+	if (result == FR_OK) {
+		sideload_reply(SIDELOAD_ACK, seq);
+	} else {
+		sideload_abort(seq);
+	}
+	if (filename) {
+		capture_UART0(NULL, 0);
+	}
+	uart0_rx_parsing = 0;
+
+	if (timeout == SIDELOAD_TIMEOUT) {
+		stats->time = clock - start;
+	}
+	return result;
+}
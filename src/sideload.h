@@ -0,0 +1,21 @@
+#ifndef SIDELOAD_H
+#define SIDELOAD_H
+
+#include "defines.h"
+
+typedef struct {
+	uint24_t bytes;	  // Data received
+	uint24_t blocks;  // Blocks received
+	uint24_t retries; // Blocks that had to be sent again
+	uint32_t time;	  // Centiseconds from the first block to the end
+} t_sideloadStats;
+
+extern void hxload_vdp(void); // In sideload.asm
+extern uint16_t crc16(uint16_t crc, const uint8_t *buf, uint16_t len);
+
+// Returned by sideload_binary if the sender stops before the end
+#define SIDELOAD_STOPPED 0xFF
+
+extern uint8_t sideload_binary(const char *filename, t_sideloadStats *stats);
+
+#endif /* SIDELOAD_H */
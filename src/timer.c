@@ -11,13 +11,19 @@
  * 31/03/2023:		Added wait_VDP
  * 08/04/2023:		Fixed timing loop in wait_VDP
  * 03/08/2023:		Fixed timer0 setup overflow in init_timer0
+ * 16/10/2026:		wait_VDP now sleeps between interrupts, times out against the clock and keeps statistics
+ * 16/10/2026:		wait_VDP_timeout falls back to a bounded loop if interrupts are disabled
  */
 
 #include "timer.h"
+#include "config.h"
 #include "defines.h"
+#include "globals.h"
 #include "ez80f92.h"
 #include "z80_io.h"
 
+t_vdpWaitStats vdp_wait_stats;
+
 // Configure Timer 0
 // Parameters:
 // - interval: Interval in ms
@@ -83,19 +89,53 @@ unsigned short get_timer0()
 // Wait for the VDP packet to come in, with a timeout
 // Parameters:
 // - mask: Mask for the packet(s) we're expecting
+// - timeout: The timeout in milliseconds
 // Returns:
 // - True if the packet is received, False if there is a timeout
 //
-bool wait_VDP(unsigned char mask)
+bool wait_VDP_timeout(unsigned char mask, int timeout)
 {
-	int i;
+	const uint32_t start = clock;
+	const uint32_t ticks = (timeout + 9) / 10 + 2; // The clock only moves on every vblank
+	const int32_t polls = (int32_t)timeout * 250;	// With interrupts disabled, roughly as long as the
+	int32_t polled = 0;				// old 250000 iteration loop took for a second
+	uint32_t elapsed;
 	bool retVal = 0;
 
-	for (i = 0; i < 250000; i++) {		 // A small delay loop (~1s)
-		if (vpd_protocol_flags & mask) { // If we get a result then
-			retVal = 1;		 // Set the return value to true
-			break;			 // And exit the loop
+	for (;;) {
+		const uint8_t ev = wait_event(&vpd_protocol_flags, mask);
+		if (ev == WAIT_EVENT_SET) {		     // If we get a result then
+			retVal = 1;			     // Set the return value to true
+			break;				     // And exit the loop
 		}
+		if (ev == WAIT_EVENT_POLLED) {		     // Interrupts are disabled, so neither the
+			if (++polled >= polls) {	     // flags nor the clock can change; don't
+				break;			     // wait on them forever
+			}
+		} else if (clock - start >= ticks) {	     // Woken by something else,
+			break;				     // so check for a timeout
+		}
+	}
+
+	elapsed = clock - start;
+	vdp_wait_stats.requests++;
+	if (!retVal) {
+		vdp_wait_stats.timeouts++;
+	}
+	vdp_wait_stats.total += elapsed;
+	if (elapsed > vdp_wait_stats.longest) {
+		vdp_wait_stats.longest = elapsed;
 	}
 	return retVal;
 }
+
+// Wait for the VDP packet to come in, with the default timeout
+// Parameters:
+// - mask: Mask for the packet(s) we're expecting
+// Returns:
+// - True if the packet is received, False if there is a timeout
+//
+bool wait_VDP(unsigned char mask)
+{
+	return wait_VDP_timeout(mask, MOS_vdpTimeout);
+}
@@ -9,6 +9,7 @@
  * 11/07/2022:		Removed unused functions
  * 13/03/2023:      Refactored
  * 31/03/2023:		Added wait_VDP
+ * 16/10/2026:		Added wait_VDP_timeout, vdp_wait_stats and wait_event
  */
 
 #ifndef TIMER_H
@@ -19,10 +20,28 @@
 extern long SysClkFreq;
 extern volatile uint8_t vpd_protocol_flags; // In globals.asm
 
+// How long the console has spent waiting for replies from the VDP
+//
+typedef struct {
+	uint24_t requests;			    // Number of waits
+	uint24_t timeouts;			    // How many of those timed out
+	uint32_t total;				    // Total time spent waiting, in centiseconds
+	uint24_t longest;			    // Longest wait, in centiseconds
+} t_vdpWaitStats;
+
+extern t_vdpWaitStats vdp_wait_stats;
+
 unsigned short init_timer0(int interval, int clkdiv, unsigned char ctrlbits);
 void enable_timer0(unsigned char enable);
 unsigned short get_timer0();
 bool wait_VDP(unsigned char mask);
+bool wait_VDP_timeout(unsigned char mask, int timeout);
+
+#define WAIT_EVENT_NONE 0	// Returned by wait_event
+#define WAIT_EVENT_SET 1
+#define WAIT_EVENT_POLLED 2
+
+uint8_t wait_event(volatile uint8_t *flags, uint8_t mask); // In misc.asm
 
 void wait_timer0();			    // In misc.asm
 
@@ -11,6 +11,11 @@
  * 23/03/2023:		Fixed maths overflow in init_UART0 to work with bigger baud rates
  * 28/03/2023:		Added support for UART1
  * 08/04/2023:		Interrupts now disabled in close_UART1
+ * 16/10/2026:		open_UART0 and open_UART1 reject baud rates the divisor can't do
+ * 16/10/2026:		UART1 is interrupt driven; open_UART1 allocates its rings and enables RTS
+ * 16/10/2026:		Added read_UART1 and write_UART1
+ * 16/10/2026:		Added capture_UART0
+ * 16/10/2026:		read_UART1 and write_UART1 sleep while waiting, and are bounded if interrupts are disabled
  *
  * NB:
  * The UART is on Port D
@@ -22,16 +27,58 @@
  */
 
 #include "uart.h"
+#include "config.h"
 #include "defines.h"
 #include "ez80f92.h"
+#include "globals.h"
+#include "timer.h"
 #include "z80_io.h"
 #include <stddef.h>
+#include <string.h>
 
 // Set the Line Control Register for data, stop and parity bits
 //
 #define SETREG_LCR0(data, stop, parity) (io_out(UART0_LCTL, ((uint8_t)(((data) - (uint8_t)5) & (uint8_t)0x3) | (uint8_t)((((stop) - (uint8_t)0x1) & (uint8_t)0x1) << (uint8_t)0x2) | (uint8_t)((parity) << (uint8_t)0x3))))
 #define SETREG_LCR1(data, stop, parity) (io_out(UART1_LCTL, ((uint8_t)(((data) - (uint8_t)5) & (uint8_t)0x3) | (uint8_t)((((stop) - (uint8_t)0x1) & (uint8_t)0x1) << (uint8_t)0x2) | (uint8_t)((parity) << (uint8_t)0x3))))
 
+t_serialRing uart1Rx;	 // UART1 receive ring, filled by the UART1 interrupt
+t_serialRing uart1Tx;	 // UART1 transmit ring, drained by the UART1 interrupt
+t_uart1Stats uart1Stats; // Characters lost on UART1 since it was opened
+t_serialRing uart0Capture; // Where UART0 receives to while it is captured
+
+// Allocate a ring buffer, if it is not already, and empty it
+// Parameters:
+// - ring: The ring
+// - size: Size of the buffer; a power of 2
+// Returns:
+// - false if there was not enough memory
+//
+static bool open_ring(t_serialRing *ring, uint24_t size)
+{
+	if (ring->buf == NULL) {
+		ring->buf = umm_malloc(size);
+		if (ring->buf == NULL) {
+			return false;
+		}
+		ring->mask = size - 1;
+	}
+	ring->head = 0;
+	ring->tail = 0;
+	return true;
+}
+
+// Free a ring buffer
+// Parameters:
+// - ring: The ring
+//
+static void close_ring(t_serialRing *ring)
+{
+	umm_free(ring->buf);
+	ring->buf = NULL;
+	ring->head = 0;
+	ring->tail = 0;
+}
+
 void init_UART0()
 {
 	io_out(PD_DR, PORTD_DRVAL_DEF);
@@ -62,6 +109,10 @@ uint8_t open_UART0(UART *pUART)
 
 	uint8_t pins = PORTPIN_ZERO | PORTPIN_ONE;		      // The transmit and receive pins
 
+	if (br == 0 || br > 0xFFFF) {				      // The divisor must fit in BRG_H:BRG_L
+		return UART_ERR_INVBAUDRATE;
+	}
+
 	serialFlags &= 0xF0;
 
 	io_setreg(PD_DDR, pins);				      // Set Port D bits 0, 1 (TX. RX) for alternate function.
@@ -102,8 +153,21 @@ uint8_t open_UART1(UART *pUART)
 
 	uint8_t pins = PORTPIN_ZERO | PORTPIN_ONE;		      // The transmit and receive pins
 
+	if (br == 0 || br > 0xFFFF) {				      // The divisor must fit in BRG_H:BRG_L
+		return UART_ERR_INVBAUDRATE;
+	}
+
+	io_out(UART1_IER, 0x00);				      // Keep the interrupt handler out while the rings are set up
 	serialFlags &= 0x0F;
 
+	if (!open_ring(&uart1Rx, MOS_uart1RxBufSize) || !open_ring(&uart1Tx, MOS_uart1TxBufSize)) {
+		close_ring(&uart1Rx);
+		close_ring(&uart1Tx);
+		return UART_ERR_FAILURE;
+	}
+	uart1Stats.overruns = 0;
+	uart1Stats.dropped = 0;
+
 	io_setreg(PC_DDR, pins);				      // Set Port C bits 0, 1 (TX. RX) for alternate function.
 	io_resetreg(PC_ALT1, pins);
 	io_setreg(PC_ALT2, pins);
@@ -112,6 +176,9 @@ uint8_t open_UART1(UART *pUART)
 		io_setreg(PC_DDR, PORTPIN_THREE);		      // Set Port C bit 3 (CTS) for input
 		io_resetreg(PC_ALT1, PORTPIN_THREE);
 		io_resetreg(PC_ALT2, PORTPIN_THREE);
+		io_setreg(PC_DDR, PORTPIN_TWO);			      // Set Port C bit 2 (RTS) for alternate function
+		io_resetreg(PC_ALT1, PORTPIN_TWO);
+		io_setreg(PC_ALT2, PORTPIN_TWO);
 		serialFlags |= 0x20;
 	}
 
@@ -119,9 +186,9 @@ uint8_t open_UART1(UART *pUART)
 	io_out(UART1_BRG_L, br & 0xFF);				      // Load divisor low
 	io_out(UART1_BRG_H, (uint8_t)((br & 0xFF00) >> 8));	      // Load divisor high
 	io_out(UART1_LCTL, io_in(UART1_LCTL) & (~UART_LCTL_DLAB));    // Reset DLAB; dont disturb other bits
-	io_out(UART1_MCTL, 0x00);				      // Bring modem control register to reset value
-	io_out(UART1_FCTL, 0x07);				      // Enable and clear hardware FIFOs
-	io_out(UART1_IER, pUART->interrupts);			      // Set interrupts
+	io_out(UART1_MCTL, (serialFlags & 0x20) ? UART_MCTL_RTS : 0x00); // Raise RTS if using flow control
+	io_out(UART1_FCTL, UART_FCTL_TRIG_8 | 0x07);		      // Enable and clear hardware FIFOs, interrupting at 8 characters
+	io_out(UART1_IER, UART_IER_RECEIVEINT);			      // The driver owns the interrupts, so pUART->interrupts is ignored
 
 	serialFlags |= 0x10;
 
@@ -130,6 +197,137 @@ uint8_t open_UART1(UART *pUART)
 	return UART_ERR_NONE;
 }
 
+// Convert a timeout in milliseconds to clock ticks
+// The clock only moves on every vblank, so this rounds up, unless there is no timeout
+//
+static uint32_t timeout_ticks(uint24_t timeout)
+{
+	return timeout ? (timeout + 9) / 10 + 2 : 0;
+}
+
+// Take characters out of a ring that an interrupt handler fills, without waiting
+// Parameters:
+// - ring: The ring
+// - buf: Where to put the characters
+// - len: The most to take
+// Returns:
+// - The number of characters taken
+//
+uint24_t serial_ring_read(t_serialRing *ring, uint8_t *buf, uint24_t len)
+{
+	const uint24_t tail = ring->tail;
+	uint24_t count = (ring->head - tail) & ring->mask; // Characters waiting in the ring
+
+	if (count > ring->mask + 1 - tail) { // Up to the end of the buffer
+		count = ring->mask + 1 - tail;
+	}
+	if (count > len) {
+		count = len;
+	}
+	if (count) {
+		memcpy(buf, ring->buf + tail, count);
+		ring->tail = (tail + count) & ring->mask;
+	}
+	return count;
+}
+
+// Read a block of characters from UART1
+// Parameters:
+// - buf: Where to put the characters
+// - len: The number of characters to read
+// - timeout: How long to wait for them, in milliseconds; 0 to only take what has already arrived
+// Returns:
+// - The number of characters read
+//
+uint24_t read_UART1(uint8_t *buf, uint24_t len, uint24_t timeout)
+{
+	const uint32_t start = clock;
+	const uint32_t ticks = timeout_ticks(timeout);
+	const uint32_t polls = (uint32_t)timeout * 250; // With interrupts disabled, as in wait_VDP_timeout
+	uint32_t polled = 0;
+	uint24_t n = 0;
+
+	while (n < len && (serialFlags & 0x10)) {
+		const uint24_t count = serial_ring_read(&uart1Rx, buf + n, len - n);
+
+		if (count == 0) {
+			if (clock - start >= ticks || polled >= polls) {
+				break;
+			}
+			if (uart1_wait(0) == WAIT_EVENT_POLLED) { // The clock has stopped
+				polled++;
+			}
+			continue;
+		}
+		n += count;
+		uart1_rts_check();
+	}
+	return n;
+}
+
+// Send what UART0 receives to a ring, rather than the one the VDP protocol is
+// parsed from, or go back to that
+// Parameters:
+// - buf: The ring buffer, or NULL to stop capturing
+// - size: Size of the buffer; a power of 2
+//
+void capture_UART0(uint8_t *buf, uint24_t size)
+{
+	if (buf == NULL) {
+		serialFlags &= ~0x04; // The handler stops using the ring at once
+		uart0Capture.buf = NULL;
+		return;
+	}
+	uart0Capture.buf = buf;
+	uart0Capture.mask = size - 1;
+	uart0Capture.head = 0;
+	uart0Capture.tail = 0;
+	serialFlags |= 0x04; // Only once the ring is set up
+}
+
+// Write a block of characters to UART1
+// Parameters:
+// - buf: The characters
+// - len: The number of characters to write
+// - timeout: How long to wait for room in the transmit ring, in milliseconds; 0 to not wait
+// Returns:
+// - The number of characters written
+//
+uint24_t write_UART1(const uint8_t *buf, uint24_t len, uint24_t timeout)
+{
+	const uint32_t start = clock;
+	const uint32_t ticks = timeout_ticks(timeout);
+	const uint32_t polls = (uint32_t)timeout * 250;
+	uint32_t polled = 0;
+	uint24_t n = 0;
+
+	while (n < len && (serialFlags & 0x10)) {
+		const uint24_t head = uart1Tx.head;
+		uint24_t count = uart1Tx.mask - ((head - uart1Tx.tail) & uart1Tx.mask); // Room in the ring
+
+		if (count == 0) {
+			if (clock - start >= ticks || polled >= polls) {
+				break;
+			}
+			if (uart1_wait(1) == WAIT_EVENT_POLLED) {
+				polled++;
+			}
+			continue;
+		}
+		if (count > uart1Tx.mask + 1 - head) { // Up to the end of the buffer
+			count = uart1Tx.mask + 1 - head;
+		}
+		if (count > len - n) {
+			count = len - n;
+		}
+		memcpy(uart1Tx.buf + head, buf + n, count);
+		uart1Tx.head = (head + count) & uart1Tx.mask;
+		n += count;
+		uart1_tx_kick();
+	}
+	return n;
+}
+
 // Close UART1
 //
 void close_UART1()
@@ -139,4 +337,6 @@ void close_UART1()
 	io_out(UART1_MCTL, 0x00); // Bring modem control register to reset value.
 	io_out(UART1_FCTL, 0x00); // Bring FIFO control register to reset value.
 	serialFlags &= 0x0F;
+	close_ring(&uart1Rx);	  // Free the rings
+	close_ring(&uart1Tx);
 }
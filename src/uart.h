@@ -9,6 +9,10 @@
  * 23/03/2023:		Fixed maths overflow in init_UART0 to work with bigger baud rates
  * 29/03/2023:		Added support for UART1
  * 16/05/2023:		Fixed MASTERCLOCK
+ * 16/10/2026:		Added the UART1 receive and transmit rings
+ * 16/10/2026:		Added read_UART1 and write_UART1
+ * 16/10/2026:		Added uart0_rx_read
+ * 16/10/2026:		Added capture_UART0 and serial_ring_read
  */
 
 #ifndef UART_H
@@ -169,6 +173,23 @@ typedef struct {
 	uint8_t interrupts;  // The enabled interrupts
 } UART;
 
+// A ring buffer for an interrupt-driven UART (see serial.asm)
+// The buffer size is a power of 2; one slot is always left free, so head == tail means empty
+//
+typedef struct {
+	uint8_t *buf;		// The buffer
+	uint24_t mask;		// The size of the buffer - 1
+	volatile uint24_t head; // Where the next character is added
+	volatile uint24_t tail; // Where the next character is removed from
+} t_serialRing;
+
+// UART1 receive statistics
+//
+typedef struct {
+	uint24_t overruns; // Characters lost because the UART1 FIFO overran
+	uint24_t dropped;  // Characters lost because the receive ring was full
+} t_uart1Stats;
+
 void init_UART0();
 void init_UART1();
 
@@ -177,10 +198,27 @@ uint8_t open_UART1(UART *pUART);
 
 void close_UART1();
 
+void capture_UART0(uint8_t *buf, uint24_t size);
+uint24_t serial_ring_read(t_serialRing *ring, uint8_t *buf, uint24_t len);
+uint24_t read_UART1(uint8_t *buf, uint24_t len, uint24_t timeout);
+uint24_t write_UART1(const uint8_t *buf, uint24_t len, uint24_t timeout);
+
 extern volatile uint8_t serialFlags; // In globals.asm
 
+extern t_serialRing uart1Rx;
+extern t_serialRing uart1Tx;
+extern t_uart1Stats uart1Stats;
+extern t_serialRing uart0Capture;
+
 extern INT uart0_putch(INT ich);
 extern INT putch(INT ich);	     // Now in serial.asm
+extern void putblock(const char *buf, INT len); // In serial.asm
 extern INT getch(void);		     // Now in serial.asm
+extern void uart1_tx_kick(void);		// In serial.asm
+extern void uart1_rts_check(void);
+extern uint8_t uart1_wait(uint8_t tx);		// Returns a WAIT_EVENT_ value (see timer.h)
+extern uint8_t uart0_rx_read(uint8_t *buf, uint8_t len);
+
+extern volatile uint8_t uart0_rx_parsing; // In interrupts.asm; set while uart0_rx_read is used
 
 #endif				     /* UART_H */
@@ -19,6 +19,8 @@
 ; 03/08/2023:	Added user_kbvector in vdp_protocol_KEY
 ; 13/08/2023:	Moved keyboard handling to keyboard.asm
 ; 26/09/2023:	RTC packet length reduced to 6 bytes
+; 16/10/2026:	Packets longer than VDPP_BUFFERLEN can be received into a caller's buffer
+; 16/10/2026:	vdp_protocol_MODE clears vdp_colours_known
 
 			INCLUDE	"macros.inc"
 			INCLUDE	"equs.inc"
@@ -60,6 +62,11 @@
 			XREF	_vdp_protocol_len
 			XREF	_vdp_protocol_ptr
 			XREF	_vdp_protocol_data
+			XREF	_vdp_bulk_ptr
+			XREF	_vdp_bulk_size
+			XREF	_vdp_bulk_cmd
+			XREF	_vdp_bulk_len
+			XREF	_vdp_colours_known
 
 			XREF	_user_kbvector
 
@@ -76,6 +83,8 @@ vdp_protocol:		LD	A, (_vdp_protocol_state)
 			JR	Z, vdp_protocol_state2
 			DEC	A
 			JP	Z, vdp_protocol_state3
+			DEC	A
+			JP	Z, vdp_protocol_state4
 			XOR	A
 			LD	(_vdp_protocol_state), A
 			RET
@@ -97,7 +106,21 @@ vdp_protocol_state0:	LD	A, C			; Wait for a header byte (bit 7 set)
 vdp_protocol_state1:	LD	A, C			; Fetch the length byte
 			CP	VDPP_BUFFERLEN + 1	; Check if it exceeds buffer length (16)
 			JR	C, 1f			;
-			LD	A, 3			; If it does exceed buffer length, switch to state 3 (ignore packet)
+			LD	(_vdp_protocol_len), A	; Store the length
+			LD	A, (_vdp_bulk_size)	; Check if it fits in the caller's buffer
+			CP	C
+			JR	C, 2f
+			LD	A, (_vpd_protocol_flags)	; And that the last long packet has been collected
+			AND	80h
+			JR	NZ, 2f
+			LD	A, C			; Stream the packet into the caller's buffer
+			LD	(_vdp_bulk_len), A
+			LD	HL, (_vdp_bulk_ptr)
+			LD	(_vdp_protocol_ptr), HL
+			LD	A, 4			; Switch to state 4 (long packet)
+			LD	(_vdp_protocol_state), A
+			RET
+2:			LD	A, 3			; Otherwise switch to state 3 (ignore packet)
 			LD	(_vdp_protocol_state), A
 			RET
 ;
@@ -161,6 +184,26 @@ vdp_protocol_state3:	LD	A, (_vdp_protocol_len)
 			LD	(_vdp_protocol_state), A
 			RET
 
+;
+; Read a long packet body into the caller's buffer
+; The packet is not actioned; the caller is told it has arrived with bit 7 of
+; _vpd_protocol_flags, and picks up the command and length from the sysvars
+;
+vdp_protocol_state4:	LD	HL, (_vdp_protocol_ptr)	; Get the buffer pointer
+			LD	(HL), C			; Store the byte in it
+			INC	HL			; Increment the buffer pointer
+			LD	(_vdp_protocol_ptr), HL
+			LD	A, (_vdp_protocol_len)	; Decrement the length
+			DEC	A
+			LD	(_vdp_protocol_len), A
+			RET	NZ			; Stay in this state if there are still bytes to read
+			LD	(_vdp_protocol_state), A	; Reset the state
+			LD	A, (_vdp_protocol_cmd)	; Store the command byte
+			LD	(_vdp_bulk_cmd), A
+			LD	HL, _vpd_protocol_flags	; And flag that the packet has been received
+			SET	7, (HL)
+			RET
+
 ; General Poll
 ;
 vdp_protocol_GP:	LD	A, (_vdp_protocol_data + 0)
@@ -297,6 +340,8 @@ vdp_protocol_MODE:	LD	A, (_vdp_protocol_data+0)
 			LD	(_scrcolours), A
 			LD	A, (_vdp_protocol_data+7)
 			LD	(_scrmode), A
+			XOR	A, A				; The text colours may have been reset
+			LD	(_vdp_colours_known), A
 			LD	A, (_vpd_protocol_flags)
 			OR	VDPP_FLAG_MODE
 			LD	(_vpd_protocol_flags), A			